@@ -0,0 +1,29 @@
+.extern Ex4
+.extern Ex
+.extern Z
+.extern Y
+.entry S3
+.entry Arr
+.entry S5
+mov #-15, r2
+cmp Ex4, D157
+add r5, S3.2
+sub r1, r3
+not S5.1
+clr Ex
+lea Arr, r5
+inc Ex
+mov #20, Z
+dec S5.1
+jmp r7
+bne D168.2
+red Arr
+prn #-22
+jsr Y
+rts
+stop
+Arr: .data 1, 3, -15, 100
+S3: .struct 8, "testing..."
+D157: .data 97, 97, 97, 97, 97, 0
+S5: .struct -15, "bbb"
+D168: .struct -19, "abcd"
@@ -0,0 +1,18 @@
+.extern W
+.extern L3
+.entry LOOP
+.entry LENGTH
+mov D133.1, W
+add r2, D122
+LOOP: jmp W
+prn #-5
+sub r1, r4
+inc D132
+mov D133.2, r3
+bne L3
+stop
+D122: .data 97, 98, 99, 100, 101, 102
+.data 0
+LENGTH: .data 6, -9, 15
+D132: .data 22
+D133: .struct 8, "ab"
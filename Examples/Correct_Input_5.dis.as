@@ -0,0 +1,29 @@
+.extern Ext1
+.extern Ext2
+.entry X
+.entry Y
+.entry L1
+.entry L2
+L1: mov r1, r2
+cmp #-13, #15
+add D141.1, X
+sub #20, r5
+L2: not PSW
+clr Ext1
+lea D147.2, r3
+inc D147.1
+dec Ext2
+jmp Y
+bne Y
+red D159
+prn #15
+jsr Ext1
+rts
+stop
+Y: .data 1, 511, -5, -15
+D141: .struct -512, "aaaa"
+D147: .struct 511, "bbbb"
+X: .data 1, 2, 3, 4, 5, 6
+D159: .data 97, 98, 99, 100, 101, 0
+.data 110, 111, 95, 108, 97, 98
+.data 101, 108, 0
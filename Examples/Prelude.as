@@ -0,0 +1,4 @@
+; the declarations shared by the examples which are assembled with a prelude
+
+.extern L3
+.extern W
@@ -0,0 +1,18 @@
+; the example in the course's booklet
+; should produce all three files, with the prelude "Prelude.as"
+
+.entry LOOP
+.entry LENGTH
+MAIN: mov S1.1, W
+add r2,STR
+LOOP: jmp W
+prn #-5
+sub r1, r4
+inc K
+mov S1.2, r3
+bne L3
+END: stop
+STR: .string "abcdef"
+LENGTH: .data 6,-9,15
+K: .data 22
+S1: .struct 8, "ab"
@@ -0,0 +1,330 @@
+#define _POSIX_C_SOURCE 200809L
+#include "assembler.h"
+
+/*
+ * This module assembles a source, either a file named on the command line, whose
+ * output files are written next to it, or a source held in memory, whose outputs
+ * are returned in memory, so the assembler can be used as a library by programs
+ * which would otherwise run it once for each source. both go through the same
+ * passes, with a context of their own (see "assembler_context"). a fatal error,
+ * like running out of memory, does not exit the program: it jumps back to a
+ * recovery point set here, where everything the file's processing allocated
+ * through the modules' state is freed and the file is reported as failed.
+ */
+
+/*
+ * add_extension:
+ * creates a new string named "output" large enough to hold both "string" and
+ * "extension" when combined to one string, and combines them to one string,
+ * returning the result string.
+ */
+char *add_extension(const char *string, const char *extension){
+    char *output;
+    output = (char*)malloc((1 + strlen(extension)+strlen(string))*sizeof(char));
+    if (!output)
+        return exit_program_fatal_error();
+    strcpy(output, string);
+    strcat(output, extension);
+    return output;
+}
+
+/*
+ * run_passes:
+ * loads the different components required for input processing: symbols table,
+ * memory and second pass lists, then calls the first and second pass processors
+ * on the input loaded to "context". with "ir_name", the first pass's
+ * state is kept in the IR file of that name (see the "ir_cache" module), and
+ * restored from it when the source did not change. returns 1 if no errors were
+ * detected by either of the processors, 0 otherwise.
+ */
+static int run_passes(assembler_context *context, char *ir_name){
+    int status;
+    initialize_symbol_table(context);
+    initialize_memory(context);    
+    initialize_second_pass_lists(context);
+    status = ir_name ? ir_first_pass(context, ir_name) : first_pass_process(context);
+    return status && second_pass_process(context) && !get_memmory_full_flag(context);
+}
+
+/*
+ * release_passes:
+ * frees the components loaded by "run_passes" and the input. the components
+ * are freed whatever state they were left in, so it's also used after a fatal
+ * error.
+ */
+static void release_passes(assembler_context *context){
+    free_symbol_table(context);
+    free_memory(context);
+    close_input_file(context);
+    free_second_pass_lists(context);
+}
+
+/*
+ * name_output_files:
+ * stores in "names" the names of the output files of "output_name" with the
+ * extra "outputs": the object file, the ".ent" and ".ext" files, and the binary
+ * object and relocation table files if selected, and returns their number.
+ */
+static int name_output_files(char **names, char *output_name, int outputs){
+    int count = 0;
+    names[count++] = add_extension(output_name, get_output_backend()->object_extension);
+    names[count++] = add_extension(output_name, ".ent");
+    names[count++] = add_extension(output_name, ".ext");
+    if (outputs & BINARY_OBJECT_OUTPUT)
+        names[count++] = add_extension(output_name, BINARY_EXTENSION);
+    if (outputs & RELOCATION_OUTPUT)
+        names[count++] = add_extension(output_name, RELOCATION_EXTENSION);
+    return count;
+}
+
+/*
+ * assemble_to_files:
+ * calls "run_passes" on the input loaded to "context", and if no
+ * errors were detected, produces the output files named in "names" (as set
+ * by "name_output_files" with "outputs"), keeping the first pass's state in
+ * the IR file "ir_name" if it's not NULL. the file's time limit is checked
+ * once more before the files are written. returns 1 if no errors were detected,
+ * 0 otherwise.
+ */
+static int assemble_to_files(assembler_context *context, char **names, int outputs, char *ir_name){
+    int status, count = OUTPUT_FILES_BASE_COUNT;
+    status = run_passes(context, ir_name);
+    if (status){
+        check_time_limit();
+        save_memory_to_file(context, names[0]);
+        create_entries_file(context, names[1]);
+        create_externs_files(context, names[2]);
+        if (outputs & BINARY_OBJECT_OUTPUT)
+            save_memory_to_binary_file(context, names[count++], get_entries_table(context), get_externs_table(context));
+        if (outputs & RELOCATION_OUTPUT)
+            save_relocations_to_file(names[count++], get_relocations_table(context));
+    }
+    return status;
+}
+
+/*
+ * assemble_and_store:
+ * like "assemble_to_files", but the messages printed meanwhile are captured,
+ * and printed once it's done, and if no errors were detected, the "count" output
+ * files are stored in the output cache with them and the number of lines read,
+ * under "key".
+ */
+static int assemble_and_store(assembler_context *context, char **names, int count, int outputs, char *ir_name, const char *key){
+    output_capture *capture;
+    int status;
+    begin_capture();
+    status = assemble_to_files(context, names, outputs, ir_name);
+    capture = end_capture();
+    fwrite(capture->out_text, 1, capture->out_length, status_output());
+    fwrite(capture->err_text, 1, capture->err_length, error_output());
+    if (status)
+        output_cache_store(key, names, count, get_line_count(context), capture->out_text, capture->out_length,
+                capture->err_text, capture->err_length);
+    free_capture(capture);
+    return status;
+}
+
+/*
+ * process_file:
+ * takes "filename" string which does not include the ".as"  extension at its end 
+ * adds the extensions, using "add_extension" function, and calls "run_passes" on
+ * the file's contents. the output files are named after "output_name" the same way. if no errors were detected by either of the processors the
+ * output files are produced, the object file's extension depends on the output format.
+ * the ".ob" and ".ext" are guaranteed to be error free if the
+ * program decides to produce them, the ".ent" file creator might still report an error
+ * and will not be produced if a certain ".entry" directive's label (operand) was
+ * not defined in the input file. the binary object and the relocation table files
+ * are produced as well when "outputs" includes "BINARY_OBJECT_OUTPUT" and
+ * "RELOCATION_OUTPUT". with an output cache (see the "output_cache" module), the
+ * output files of a source assembled before with the same options are restored
+ * from the cache instead, and otherwise stored in it once produced. with IR files
+ * (see the "ir_cache" module), the first pass's state is kept in the file's IR
+ * file, named after "filename", and restored from it. if there was
+ * a problem opening the input file, an error is printed. the files' names are
+ * kept in the context's "file_names": the source's, the IR file's (NULL
+ * without one) and then the output files', for "release_file_names" to free.
+ * returns 1 if the file was assembled without errors (or restored), 0 otherwise.
+ */
+static int process_file(assembler_context *context, char *filename, char *output_name, int outputs){
+    char **files_names = context->file_names, **output_names = files_names + 2, key[OUTPUT_KEY_SIZE];
+    int status = 0, count;
+    files_names[0] = add_extension(filename, ".as");
+    if (ir_cache_enabled())
+        files_names[1] = add_extension(filename, IR_EXTENSION);
+    if (load_input_file(context, files_names[0])){
+        count = name_output_files(output_names, output_name, outputs);
+        if (output_cache_enabled()){
+            output_cache_key(context->first_pass.input.text, context->first_pass.input.length, outputs, key);
+            check_time_limit();
+            status = output_cache_restore(key, output_names, count, &context->first_pass.line_count)
+                    || assemble_and_store(context, output_names, count, outputs, files_names[1], key);
+        }
+        else status = assemble_to_files(context, output_names, outputs, files_names[1]);
+    }
+    else fprintf(error_output(), "Error: unable to open file \"%s\".\n", filename);
+    return status;
+}
+
+/*
+ * release_file_names:
+ * frees the names of files kept in "context" by "process_file".
+ */
+static void release_file_names(assembler_context *context){
+    char **files_names = context->file_names;
+    int i;
+    for (i = 0; i < FILE_NAMES_COUNT; i++){
+        free(files_names[i]);
+        files_names[i] = NULL;
+    }
+}
+
+/*
+ * assemble_file:
+ * assembles the file named "filename" (without the ".as" extension) as the
+ * command line does, with the current context, between messages announcing it.
+ * "outputs" selects the extra files to produce (see "process_file"). a fatal
+ * error stops the file's processing and the next file can still be assembled.
+ * returns 1 if the file was assembled without errors, 0 otherwise.
+ */
+int assemble_file(char *filename, int outputs){
+    return assemble_file_to(filename, filename, outputs);
+}
+
+/*
+ * assemble_file_to:
+ * like "assemble_file", but the output files are named after "output_name"
+ * (without an extension) instead of "filename". a file which goes over its
+ * limits (see "resource_limits") is stopped like after a fatal error. the
+ * names of files and the captures of messages a fatal error left behind are
+ * released afterwards, with the context's streams set back.
+ */
+int assemble_file_to(char *filename, char *output_name, int outputs){
+    assembler_context *context = current_context();
+    FILE *out = context->out, *err = context->err;
+    jmp_buf recovery;
+    volatile int status = 0;
+    fprintf(status_output(), "\nProcessing file \"%s.as\"...\n\n", filename);
+    context->recovery = &recovery;
+    begin_resource_usage();
+    if (!setjmp(recovery))
+        status = process_file(context, filename, output_name, outputs);
+    release_captures();
+    release_file_names(context);
+    release_passes(context);
+    context->recovery = NULL;
+    context->out = out;
+    context->err = err;
+    fprintf(status_output(), "\nDone processing file \"%s.as\".\n\n", filename);
+    return status;
+}
+
+/*
+ * assemble_loaded_source:
+ * assembles the source loaded to "context" into "result": if no
+ * errors are found, the object, entries and externs files are built in its
+ * buffers. returns 1 if no errors were found, 0 otherwise.
+ */
+static int assemble_loaded_source(assembler_context *context, assembly_result *result){
+    int status;
+    status = run_passes(context, NULL);
+    if (status){
+        check_time_limit();
+        save_memory_to_buffer(context, &result->object);
+        status = build_entries(context, &result->entries);
+        build_externs(context, &result->externs);
+    }
+    return status;
+}
+
+/*
+ * run_protected:
+ * loads the "length" characters of "source" and assembles them into "result"
+ * with a recovery point for fatal errors, which leave the status as it was set
+ * by the caller. the files' contents are kept only if the assembly succeeded.
+ */
+static void run_protected(assembler_context *context, const char *source, size_t length, assembly_result *result){
+    jmp_buf recovery;
+    context->recovery = &recovery;
+    begin_resource_usage();
+    if (!setjmp(recovery)){
+        load_input_text(context, source, length);
+        result->status = assemble_loaded_source(context, result) ? ASSEMBLY_SUCCESS : ASSEMBLY_ERRORS;
+    }
+    release_captures();
+    release_passes(context);
+    context->recovery = NULL;
+    if (result->status != ASSEMBLY_SUCCESS){
+        output_buffer_free(&result->object);
+        output_buffer_free(&result->entries);
+        output_buffer_free(&result->externs);
+    }
+}
+
+/*
+ * captured_text:
+ * sets "buffer" to the "length" characters of "text", captured by a memory
+ * stream, so it can be used and freed as any other buffer.
+ */
+static void captured_text(output_buffer *buffer, char *text, size_t length){
+    buffer->text = text;
+    buffer->length = length;
+    buffer->capacity = length + 1;
+}
+
+/*
+ * assemble_source:
+ * assembles the "length" characters of "source" as if they were the contents
+ * of an ".as" file, without reading or writing any file, and stores the
+ * results in "result", which should be freed by "free_assembly_result". the
+ * messages are captured in "result" instead of being printed. may be called
+ * by several threads at the same time. returns the status of the assembly,
+ * which is also stored in "result": "ASSEMBLY_SUCCESS", "ASSEMBLY_ERRORS" or
+ * "ASSEMBLY_OUT_OF_MEMORY", if a fatal error, or going over a resource limit
+ * (see "resource_limits"), stopped it.
+ */
+int assemble_source(const char *source, size_t length, assembly_result *result){
+    assembler_context *previous, *context = (assembler_context*)malloc(sizeof(assembler_context));
+    char *out_text = NULL, *err_text = NULL;
+    size_t out_length = 0, err_length = 0;
+    memset(result, 0, sizeof(assembly_result));
+    result->status = ASSEMBLY_OUT_OF_MEMORY;
+    if (!context)
+        return result->status;
+    enable_thread_contexts();
+    previous = current_context();
+    initialize_context(context);
+    context->out = open_memstream(&out_text, &out_length);
+    context->err = open_memstream(&err_text, &err_length);
+    if (context->out && context->err){
+        context->diagnostics = &result->diagnostics;
+        set_current_context(context);
+        run_protected(context, source, length, result);
+        set_current_context(previous);
+    }
+    if (context->out){
+        fclose(context->out);
+        captured_text(&result->messages, out_text, out_length);
+    }
+    if (context->err){
+        fclose(context->err);
+        captured_text(&result->errors, err_text, err_length);
+    }
+    free(context);
+    return result->status;
+}
+
+/*
+ * free_assembly_result:
+ * frees the buffers and the diagnostics stored in "result" by "assemble_source".
+ */
+void free_assembly_result(assembly_result *result){
+    output_buffer_free(&result->object);
+    output_buffer_free(&result->entries);
+    output_buffer_free(&result->externs);
+    output_buffer_free(&result->messages);
+    output_buffer_free(&result->errors);
+    free(result->diagnostics.items);
+    result->diagnostics.items = NULL;
+    result->diagnostics.count = 0;
+    result->diagnostics.capacity = 0;
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include "assembler_context.h"
+    #include "output_buffer.h"
+    #include "binary_object.h"
+    #include "relocation.h"
+    #include "output_cache.h"
+    #include "ir_cache.h"
+
+    /*the extra files "assemble_file" writes, combined with "|"*/
+    #define BINARY_OBJECT_OUTPUT 1
+    #define RELOCATION_OUTPUT 2
+    /*the number of output files of an assembled file: always, and at most*/
+    #define OUTPUT_FILES_BASE_COUNT 3
+    #define OUTPUT_FILES_COUNT 5
+
+    /*the ways assembling a source can end*/
+    typedef enum assembly_status {ASSEMBLY_SUCCESS, ASSEMBLY_ERRORS, ASSEMBLY_OUT_OF_MEMORY} assembly_status;
+
+    /*
+     * the results of assembling a source in memory: its "status", the contents
+     * of the object file (in the selected output format), the entries and the
+     * externs files, which are empty unless the status is "ASSEMBLY_SUCCESS",
+     * the status "messages" and the "errors" text as the program prints them,
+     * and the errors and warnings as a list of "diagnostics".
+     */
+    typedef struct assembly_result {
+        int status;
+        output_buffer object;
+        output_buffer entries;
+        output_buffer externs;
+        output_buffer messages;
+        output_buffer errors;
+        diagnostic_list diagnostics;
+    } assembly_result;
+
+    int assemble_source(const char*, size_t, assembly_result*);
+    void free_assembly_result(assembly_result*);
+    int assemble_file(char*, int);
+    int assemble_file_to(char*, char*, int);
+    char *add_extension(const char*, const char*);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,153 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include "assembler_context.h"
+
+/*
+ * This module holds the state of the assembler while it processes a file. the
+ * modules taking part in assembling a file (the first and second pass
+ * processors, the symbol table and the memory manager) keep their state in
+ * the current context rather than in static variables, so each thread can
+ * process a different file at the same time, with its own context. the
+ * context is passed to the functions of those modules, while the others,
+ * which need it rarely (to report errors, for example), find it with
+ * "current_context". a single threaded program uses the default context and
+ * never needs to set one. the messages printed to a
+ * context may be captured in memory (see "begin_capture"), the captures are
+ * kept in the context so they can be released after a fatal error.
+ */
+
+/*
+ * "default_context": the context used by threads which did not set their own,
+ * its streams are set to stdout and stderr when it's first used.
+ * "threaded" indicates whether "enable_thread_contexts" was called, so threads
+ * may have contexts of their own, stored under "context_key". "key_once" makes
+ * sure the key is created once.
+ */
+static assembler_context default_context;
+static int threaded = 0;
+static pthread_key_t context_key;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+
+/*
+ * create_context_key:
+ * creates the key the threads' contexts are stored under, and initializes the
+ * default context before any of the threads may fall back to it.
+ */
+static void create_context_key(void){
+    if (pthread_key_create(&context_key, NULL))
+        exit_program_fatal_error();
+    if (!default_context.out)
+        initialize_context(&default_context);
+    threaded = 1;
+}
+
+/*
+ * initialize_context:
+ * sets "context" to an empty state, printing to stdout and stderr. the
+ * modules' initializers should still be called before processing a file.
+ */
+void initialize_context(assembler_context *context){
+    memset(context, 0, sizeof(assembler_context));
+    context->out = stdout;
+    context->err = stderr;
+}
+
+/*
+ * enable_thread_contexts:
+ * allows threads to set their own contexts with "set_current_context", should
+ * be called before starting the threads, calling it again has no effect.
+ */
+void enable_thread_contexts(void){
+    pthread_once(&key_once, create_context_key);
+}
+
+/*
+ * set_current_context:
+ * makes "context" the current context of the calling thread, until it sets
+ * another. "enable_thread_contexts" must have been called.
+ */
+void set_current_context(assembler_context *context){
+    pthread_setspecific(context_key, context);
+}
+
+/*
+ * current_context:
+ * returns the context of the calling thread, or the default context if the
+ * thread did not set one.
+ */
+assembler_context *current_context(void){
+    assembler_context *context;
+    if (threaded && (context = (assembler_context*)pthread_getspecific(context_key)))
+        return context;
+    if (!default_context.out)
+        initialize_context(&default_context);
+    return &default_context;
+}
+
+/*
+ * begin_capture:
+ * captures the messages printed to the current context from now on in memory,
+ * until "end_capture" is called.
+ */
+void begin_capture(void){
+    assembler_context *context = current_context();
+    output_capture *capture = (output_capture*)calloc(1, sizeof(output_capture));
+    if (!capture)
+        exit_program_fatal_error();
+    capture->out = context->out;
+    capture->err = context->err;
+    capture->outer = context->capture;
+    context->capture = capture;
+    context->out = open_memstream(&capture->out_text, &capture->out_length);
+    context->err = open_memstream(&capture->err_text, &capture->err_length);
+    if (!context->out || !context->err){
+        free_capture(end_capture());
+        exit_program_fatal_error();
+    }
+}
+
+/*
+ * end_capture:
+ * ends the innermost capture of the current context's messages, which go back
+ * to the streams they were printed to before it began. returns the capture,
+ * holding the captured messages, which should be freed by "free_capture".
+ */
+output_capture *end_capture(void){
+    assembler_context *context = current_context();
+    output_capture *capture = context->capture;
+    if (context->out)
+        fclose(context->out);
+    if (context->err)
+        fclose(context->err);
+    context->out = capture->out;
+    context->err = capture->err;
+    context->capture = capture->outer;
+    return capture;
+}
+
+/*
+ * free_capture:
+ * frees "capture", returned by "end_capture", with the messages it holds.
+ */
+void free_capture(output_capture *capture){
+    free(capture->out_text);
+    free(capture->err_text);
+    free(capture);
+}
+
+/*
+ * release_captures:
+ * ends every capture of the current context's messages still in progress,
+ * after a fatal error stopped the file, printing the messages each captured
+ * to the streams it replaced, so none is lost, and frees them.
+ */
+void release_captures(void){
+    assembler_context *context = current_context();
+    output_capture *capture;
+    while (context->capture){
+        capture = end_capture();
+        fwrite(capture->out_text, 1, capture->out_length, context->out);
+        fwrite(capture->err_text, 1, capture->err_length, context->err);
+        free_capture(capture);
+    }
+}
\ No newline at end of file
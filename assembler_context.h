@@ -0,0 +1,68 @@
+#ifndef ASSEMBLER_CONTEXT_H
+#define ASSEMBLER_CONTEXT_H
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <setjmp.h>
+    #include "error_handler.h"
+    #include "symbol_table.h"
+    #include "memory_manager.h"
+    #include "first_pass_processor.h"
+    #include "second_pass_processor.h"
+    #include "resource_limits.h"
+
+    /*the most names of files assembling one file allocates: its source, its IR and its output files*/
+    #define FILE_NAMES_COUNT 7
+
+    /*
+     * the messages of a context captured in memory: "out" and "err" are the
+     * streams they were printed to before, the "out_length" characters of
+     * "out_text" and the "err_length" characters of "err_text" were captured,
+     * and "outer" is the capture which was in progress when it began, if any.
+     */
+    typedef struct output_capture {
+        FILE *out;
+        FILE *err;
+        char *out_text;
+        char *err_text;
+        size_t out_length;
+        size_t err_length;
+        struct output_capture *outer;
+    } output_capture;
+
+    /*
+     * the state of assembling one file: the state of each of the modules taking
+     * part in it, and the streams "out" and "err" its status messages and its
+     * errors are printed to (stdout and stderr, unless they are captured).
+     * "diagnostics" collects the errors and warnings as well, unless it's NULL,
+     * and "recovery", unless NULL, is where fatal errors jump back to. "usage" is
+     * what the file used of the resources it's limited in (see "resource_limits").
+     * "file_names" holds the names of files allocated while the file is processed
+     * and "capture" the innermost capture of its messages in progress, so both
+     * can be freed after a fatal error. the type is declared by "symbol_table",
+     * so the headers of the modules receiving it can use it.
+     */
+    struct assembler_context {
+        first_pass_state first_pass;
+        hash_table *symbol_table;
+        memory_state memory;
+        second_pass_state second_pass;
+        FILE *out;
+        FILE *err;
+        diagnostic_list *diagnostics;
+        jmp_buf *recovery;
+        resource_usage usage;
+        char *file_names[FILE_NAMES_COUNT];
+        output_capture *capture;
+    };
+
+    void initialize_context(assembler_context*);
+    void enable_thread_contexts(void);
+    void set_current_context(assembler_context*);
+    assembler_context *current_context(void);
+    void begin_capture(void);
+    output_capture *end_capture(void);
+    void free_capture(output_capture*);
+    void release_captures(void);
+
+#endif
\ No newline at end of file
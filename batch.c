@@ -0,0 +1,219 @@
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#include <sys/stat.h>
+#include "batch.h"
+
+/*
+ * This module assembles the files listed in a manifest, instead of on the
+ * command line, and prints a summary of the whole batch once it's done: the
+ * number of files which succeeded and failed, the lines read and how fast,
+ * the percentiles of the time each file took, how many instruction lines were
+ * found in the encoded lines cache, and the use of the output cache if there
+ * is one. each line of a manifest holds the name of a file (the ".as"
+ * extension is optional), and optionally, after a tab, the directory its output
+ * files are written to (created if missing), otherwise they are written next
+ * to it. empty lines and lines
+ * starting with ';' are skipped. the status messages of each file are not
+ * printed unless asked to, its errors are, followed by a line naming it.
+ */
+
+/*
+ * "entries" and "entries_count": the files listed in the manifest, their names
+ * point into the manifest's text, in the order they appear.
+ * "batch_outputs": the extra files to produce (see "assemble_file").
+ * "quiet_output": the stream the status messages of the files are printed to
+ * instead of the current context's, NULL if they are printed.
+ */
+static batch_entry *entries = NULL;
+static int entries_count = 0;
+static int batch_outputs = 0;
+static FILE *quiet_output = NULL;
+
+/*
+ * current_seconds:
+ * returns the time in seconds from some fixed point, for measuring durations.
+ */
+static double current_seconds(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/*
+ * directory_output_name:
+ * returns a new string naming the output files of the file "name" in the
+ * directory "directory", which is created if it does not exist yet.
+ */
+static char *directory_output_name(char *name, char *directory){
+    char *base = strrchr(name, '/'), *output;
+    base = base ? base + 1 : name;
+    output = (char*)malloc(strlen(directory) + strlen(base) + 2);
+    if (!output)
+        return exit_program_fatal_error();
+    sprintf(output, "%s/%s", directory, base);
+    mkdir(directory, 0777);
+    return output;
+}
+
+/*
+ * parse_manifest:
+ * fills "entries" with the files listed in the null terminated "text" of a
+ * manifest, which is split into the names in place.
+ */
+static void parse_manifest(char *text){
+    char *line, *next, *directory, *end;
+    int lines = 1;
+    for (line = text; *line; line++)
+        lines += *line == '\n';
+    entries = (batch_entry*)calloc(lines, sizeof(batch_entry));
+    if (!entries)
+        exit_program_fatal_error();
+    entries_count = 0;
+    for (line = text; line; line = next){
+        if ((next = strchr(line, '\n')))
+            *next++ = '\0';
+        end = line + strlen(line);
+        while (end > line && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t'))
+            *--end = '\0';
+        while (*line == ' ' || *line == '\t')
+            line++;
+        if (!*line || *line == MANIFEST_COMMENT)
+            continue;
+        if ((directory = strchr(line, '\t'))){
+            for (end = directory; *directory == '\t'; directory++)
+                ;
+            *end = '\0';
+        }
+        if ((end = line + strlen(line)) - line > 3 && !strcmp(end - 3, ".as"))
+            end[-3] = '\0';
+        entries[entries_count].name = line;
+        entries[entries_count].output_name = directory ? directory_output_name(line, directory) : line;
+        entries_count++;
+    }
+}
+
+/*
+ * assemble_entry:
+ * assembles the manifest's file named "name", the entry number "index", and
+ * records how it went and how long it took in its entry. the lines of a file
+ * restored from the output cache are the ones stored with it. may be called
+ * by several threads at the same time, each for a different file.
+ */
+static void assemble_entry(char *name, int index){
+    batch_entry *entry = entries + index;
+    assembler_context *context = current_context();
+    FILE *out = context->out;
+    double start = current_seconds();
+    if (quiet_output)
+        context->out = quiet_output;
+    entry->status = assemble_file_to(name, entry->output_name, batch_outputs);
+    entry->lines = get_line_count(context);
+    entry->seconds = current_seconds() - start;
+    if (quiet_output && !entry->status)
+        fprintf(error_output(), "Failed: \"%s.as\"%s.\n", entry->name, context->usage.exceeded ? " (over its limits)" : "");
+    context->out = out;
+}
+
+/*
+ * compare_seconds:
+ * orders two durations in seconds, for "qsort".
+ */
+static int compare_seconds(const void *first, const void *second){
+    double a = *(const double*)first, b = *(const double*)second;
+    return (a > b) - (a < b);
+}
+
+/*
+ * percentile:
+ * returns the "percent" percentile of the "count" durations in "sorted", the
+ * smallest one which is not shorter than "percent" percent of them.
+ */
+static double percentile(double *sorted, int count, int percent){
+    int rank = (percent * count + 99) / 100;
+    return count ? sorted[rank > 0 ? rank - 1 : 0] : 0;
+}
+
+/*
+ * print_summary:
+ * prints the summary of the batch, which took "seconds" in total, and returns
+ * the number of files which failed.
+ */
+static int print_summary(double seconds){
+    double *durations = (double*)malloc((entries_count + 1) * sizeof(double));
+    long lines = 0, hits, misses;
+    int i, succeeded = 0;
+    if (!durations)
+        exit_program_fatal_error();
+    for (i = 0; i < entries_count; i++){
+        succeeded += entries[i].status;
+        lines += entries[i].lines;
+        durations[i] = entries[i].seconds;
+    }
+    qsort(durations, entries_count, sizeof(double), compare_seconds);
+    printf("\nBatch summary:\n");
+    printf("Files: %d, succeeded: %d, failed: %d\n", entries_count, succeeded, entries_count - succeeded);
+    printf("Lines: %ld in %.3f seconds (%.0f lines per second)\n", lines, seconds, seconds > 0 ? lines / seconds : 0.0);
+    printf("Time per file: p50 %.3f ms, p95 %.3f ms, p99 %.3f ms\n", 1000 * percentile(durations, entries_count, 50),
+            1000 * percentile(durations, entries_count, 95), 1000 * percentile(durations, entries_count, 99));
+    hits = get_encoding_cache_hits();
+    misses = get_encoding_cache_misses();
+    printf("Encoded lines cache: %ld hits, %ld misses (%.1f%% hit rate)\n", hits, misses,
+            hits + misses ? 100.0 * hits / (hits + misses) : 0.0);
+    if (output_cache_enabled()){
+        cache_statistics cache = get_output_cache_statistics();
+        printf("Cache: %d hits, %d misses, %d stored, %d evicted\n", cache.hits, cache.misses, cache.stores, cache.evicted);
+    }
+    free(durations);
+    return entries_count - succeeded;
+}
+
+/*
+ * run_manifest:
+ * assembles the files listed in the manifest named "manifest" (the standard
+ * input if it's "-") with the extra "outputs" (see "assemble_file"), by "jobs"
+ * threads at the same time if it's more than 1, and prints the batch's summary.
+ * the status messages of each file are printed only if "verbose" is not 0.
+ * returns 1 if all the files were assembled without errors, 0 otherwise.
+ */
+int run_manifest(char *manifest, int outputs, int jobs, int verbose){
+    output_buffer text;
+    char **names;
+    int i, failed;
+    double start;
+    if (!strcmp(manifest, STANDARD_INPUT_MANIFEST)){
+        output_buffer_init(&text, 0);
+        output_buffer_read_stream(&text, stdin);
+    }
+    else if (!output_buffer_read_file(&text, manifest)){
+        fprintf(stderr, "Error: unable to open the manifest \"%s\".\n", manifest);
+        return 0;
+    }
+    output_buffer_append_char(&text, '\0');
+    parse_manifest(text.text);
+    names = (char**)malloc((entries_count + 1) * sizeof(char*));
+    if (!names)
+        exit_program_fatal_error();
+    for (i = 0; i < entries_count; i++)
+        names[i] = entries[i].name;
+    batch_outputs = outputs;
+    quiet_output = verbose ? NULL : fopen("/dev/null", "w");
+    start = current_seconds();
+    if (jobs > 1)
+        run_file_jobs(names, entries_count, jobs, assemble_entry);
+    else for (i = 0; i < entries_count; i++)
+        assemble_entry(names[i], i);
+    trim_output_cache();
+    failed = print_summary(current_seconds() - start);
+    if (quiet_output)
+        fclose(quiet_output);
+    quiet_output = NULL;
+    for (i = 0; i < entries_count; i++)
+        if (entries[i].output_name != entries[i].name)
+            free(entries[i].output_name);
+    free(entries);
+    free(names);
+    entries = NULL;
+    entries_count = 0;
+    output_buffer_free(&text);
+    return !failed;
+}
\ No newline at end of file
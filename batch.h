@@ -0,0 +1,31 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include "assembler.h"
+    #include "job_pool.h"
+
+    /*the name of the manifest which is read from the standard input*/
+    #define STANDARD_INPUT_MANIFEST "-"
+    /*the character which starts a comment line in a manifest*/
+    #define MANIFEST_COMMENT ';'
+
+    /*
+     * a file listed in a manifest: its "name" (without the ".as" extension),
+     * the name its output files are written under ("output_name"), and once it
+     * is assembled its "status" (1 if it had no errors), the number of "lines"
+     * read and the time it took in "seconds".
+     */
+    typedef struct batch_entry {
+        char *name;
+        char *output_name;
+        int status;
+        int lines;
+        double seconds;
+    } batch_entry;
+
+    int run_manifest(char*, int, int, int);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,348 @@
+#define _POSIX_C_SOURCE 200112L
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "binary_object.h"
+#include "memory_manager.h"
+#include "assembler.h"
+
+/*
+ * This module implements the binary object format: a compact alternative to the
+ * ".ob", ".ent" and ".ext" text files, which holds the same information in one
+ * file, with every word stored in 2 bytes instead of a 6 characters line. the
+ * header fixes the size of every section, so a file is validated by its header
+ * alone, and any word or symbol record is read at a computed offset. the module
+ * also converts the text files of an assembled program to a binary object file
+ * and back, without losing any information.
+ */
+
+/*
+ * put_number:
+ * stores the 16 bits of "value" at "target" in little endian order.
+ */
+static void put_number(unsigned char *target, int value){
+    target[0] = value & 0xFF;
+    target[1] = (value >> 8) & 0xFF;
+}
+
+/*
+ * get_number:
+ * returns the 16 bits number stored at "source" in little endian order.
+ */
+static int get_number(const unsigned char *source){
+    return source[0] | (source[1] << 8);
+}
+
+/*
+ * encode_binary_header:
+ * writes a binary object file header to "target", which must have room for
+ * BINARY_HEADER_SIZE bytes, for a program with "ic" instruction words, "dc"
+ * data words, "base" as its first address and the given numbers of entries
+ * and externs.
+ */
+void encode_binary_header(unsigned char *target, int ic, int dc, int base, int entries_count, int externs_count){
+    memcpy(target, BINARY_MAGIC, BINARY_MAGIC_SIZE);
+    target += BINARY_MAGIC_SIZE;
+    put_number(target, BINARY_VERSION);
+    put_number(target + BINARY_WORD_SIZE, ic);
+    put_number(target + 2 * BINARY_WORD_SIZE, dc);
+    put_number(target + 3 * BINARY_WORD_SIZE, base);
+    put_number(target + 4 * BINARY_WORD_SIZE, entries_count);
+    put_number(target + 5 * BINARY_WORD_SIZE, externs_count);
+}
+
+/*
+ * encode_binary_words:
+ * writes the 10 bits of each of the "count" words in "words" to "target",
+ * which must have room for "count" times BINARY_WORD_SIZE bytes.
+ */
+void encode_binary_words(unsigned char *target, const word *words, int count){
+    int i;
+    for (i = 0; i < count; i++, target += BINARY_WORD_SIZE)
+        put_number(target, words[i].value & (AWKWARD_VALUES - 1));
+}
+
+/*
+ * binary_symbols_append:
+ * appends a symbol record for "name" (no longer than MAX_NAME_SIZE characters)
+ * and "address" to the entries or externs table being built in "table".
+ */
+void binary_symbols_append(output_buffer *table, char *name, int address){
+    unsigned char *record = (unsigned char*)output_buffer_extend(table, BINARY_SYMBOL_SIZE);
+    size_t length = strlen(name);
+    memset(record, 0, BINARY_NAME_SIZE);
+    memcpy(record, name, length < MAX_NAME_SIZE ? length : MAX_NAME_SIZE);
+    put_number(record + BINARY_NAME_SIZE, address);
+}
+
+/*
+ * binary_object_open:
+ * maps the binary object file named "filename" to memory and validates it:
+ * its size must be exactly the one its header describes, so no other part of
+ * the file needs to be read. returns 1 on success, otherwise an error is
+ * printed and 0 is returned.
+ */
+int binary_object_open(binary_object *object, char *filename){
+    struct stat info;
+    void *data = MAP_FAILED;
+    int fd = open(filename, O_RDONLY);
+    object->data = NULL;
+    if (fd < 0){
+        fprintf(stderr, "Error: unable to open file \"%s\".\n", filename);
+        return 0;
+    }
+    if (!fstat(fd, &info) && info.st_size >= BINARY_HEADER_SIZE)
+        data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data != MAP_FAILED){
+        const unsigned char *header = (const unsigned char*)data + BINARY_MAGIC_SIZE;
+        object->data = (const unsigned char*)data;
+        object->size = info.st_size;
+        object->ic = get_number(header + BINARY_WORD_SIZE);
+        object->dc = get_number(header + 2 * BINARY_WORD_SIZE);
+        object->base = get_number(header + 3 * BINARY_WORD_SIZE);
+        object->entries_count = get_number(header + 4 * BINARY_WORD_SIZE);
+        object->externs_count = get_number(header + 5 * BINARY_WORD_SIZE);
+        object->words = object->data + BINARY_HEADER_SIZE;
+        object->entries = object->words + (size_t)(object->ic + object->dc) * BINARY_WORD_SIZE;
+        object->externs = object->entries + (size_t)object->entries_count * BINARY_SYMBOL_SIZE;
+        if (!memcmp(object->data, BINARY_MAGIC, BINARY_MAGIC_SIZE) && get_number(header) == BINARY_VERSION
+                && object->externs + (size_t)object->externs_count * BINARY_SYMBOL_SIZE == object->data + object->size)
+            return 1;
+        binary_object_close(object);
+    }
+    fprintf(stderr, "Error: \"%s\" is not a valid binary object file.\n", filename);
+    return 0;
+}
+
+/*
+ * binary_object_close:
+ * unmaps a file opened by "binary_object_open".
+ */
+void binary_object_close(binary_object *object){
+    if (object->data)
+        munmap((void*)object->data, object->size);
+    object->data = NULL;
+}
+
+/*
+ * binary_object_word:
+ * returns the 10 bits value of the word at memory index "index" (counted
+ * from the object's base address), the caller makes sure "index" is less
+ * than IC + DC.
+ */
+int binary_object_word(const binary_object *object, int index){
+    return get_number(object->words + (size_t)index * BINARY_WORD_SIZE) & (AWKWARD_VALUES - 1);
+}
+
+/*
+ * binary_symbol_read:
+ * copies the name of the symbol record at "record" to "name", which must have
+ * room for BINARY_NAME_SIZE characters, and returns the symbol's address.
+ */
+int binary_symbol_read(const unsigned char *record, char *name){
+    memcpy(name, record, MAX_NAME_SIZE);
+    name[MAX_NAME_SIZE] = '\0';
+    return get_number(record + BINARY_NAME_SIZE);
+}
+
+/*
+ * binary_object_entry:
+ * copies the name of the entry at "index" to "name" (see "binary_symbol_read")
+ * and returns its address. the caller makes sure "index" is less than the
+ * number of entries.
+ */
+int binary_object_entry(const binary_object *object, int index, char *name){
+    return binary_symbol_read(object->entries + (size_t)index * BINARY_SYMBOL_SIZE, name);
+}
+
+/*
+ * binary_object_extern:
+ * same as "binary_object_entry", for the extern at "index".
+ */
+int binary_object_extern(const binary_object *object, int index, char *name){
+    return binary_symbol_read(object->externs + (size_t)index * BINARY_SYMBOL_SIZE, name);
+}
+
+/*
+ * binary_symbols_parse:
+ * parses the ".ent" or ".ext" file named "filename", whose lines hold a symbol's
+ * name, a space and its address in the "awkward base", and appends a record to
+ * "table" for each line (see "binary_symbols_append"). a missing file has no
+ * symbols. returns the number of symbols, or -1 if the file is not in the
+ * expected format.
+ */
+int binary_symbols_parse(char *filename, output_buffer *table){
+    output_buffer file;
+    size_t length, position = 0;
+    int count = 0;
+    char *text;
+    if (!output_buffer_read_file(&file, filename)){
+        output_buffer_free(&file);
+        return 0;
+    }
+    text = file.text;
+    length = file.length;
+    while (count >= 0 && position < length){
+        char name[BINARY_NAME_SIZE];
+        size_t name_length = 0;
+        int address;
+        while (position + name_length < length && text[position + name_length] != ' ' && name_length < MAX_NAME_SIZE)
+            name_length++;
+        if (!name_length || position + name_length + 4 > length || text[position + name_length] != ' '
+                || text[position + name_length + 3] != '\n'
+                || (address = decode_awkward_word(text + position + name_length + 1)) < 0)
+            count = -1;
+        else {
+            memcpy(name, text + position, name_length);
+            name[name_length] = '\0';
+            binary_symbols_append(table, name, address);
+            position += name_length + 4;
+            count++;
+        }
+    }
+    output_buffer_free(&file);
+    return count;
+}
+
+/*
+ * parse_object_file:
+ * parses the ".ob" file in "text" of "length" characters into "words" (which
+ * must have room for MEMORY_SIZE words) and stores IC, DC and the first address
+ * in "ic", "dc" and "base". the addresses must be consecutive, so they are
+ * implied by the base, which is C when there are no words. returns 1 on success, or 0 if the text is not in the
+ * expected format.
+ */
+static int parse_object_file(const char *text, size_t length, word *words, int *ic, int *dc, int *base){
+    int i, count;
+    if (length < AWKWARD_LINE_SIZE - 1 || (length - AWKWARD_LINE_SIZE + 1) % AWKWARD_LINE_SIZE
+            || text[AWKWARD_WORD_SIZE] != '\t')
+        return 0;
+    count = (length - AWKWARD_LINE_SIZE + 1) / AWKWARD_LINE_SIZE;
+    *ic = decode_awkward_word(text);
+    *dc = decode_awkward_word(text + AWKWARD_WORD_SIZE + 1);
+    if (*ic < 0 || *dc < 0 || *ic + *dc != count || count > AWKWARD_VALUES)
+        return 0;
+    text += AWKWARD_LINE_SIZE - 1;
+    *base = count ? decode_awkward_word(text + 1) : C;
+    for (i = 0; i < count; i++, text += AWKWARD_LINE_SIZE){
+        int value = decode_awkward_word(text + 4);
+        if (text[0] != '\n' || text[3] != '\t' || value < 0
+                || decode_awkward_word(text + 1) != ((*base + i) & (AWKWARD_VALUES - 1)))
+            return 0;
+        words[i].value = value;
+    }
+    return 1;
+}
+
+/*
+ * convert_text_to_binary:
+ * converts the ".ob", ".ent" and ".ext" files of the program "name" (given
+ * without an extension) to the binary object file with the same name. returns
+ * 1 on success, otherwise an error is printed and 0 is returned.
+ */
+int convert_text_to_binary(char *name){
+    char *ob_name = add_extension(name, ".ob"), *ent_name = add_extension(name, ".ent");
+    char *ext_name = add_extension(name, ".ext"), *binary_name = add_extension(name, BINARY_EXTENSION);
+    output_buffer text, entries, externs, output;
+    word *words = (word*)malloc(AWKWARD_VALUES * sizeof(word));
+    int ic, dc, base, entries_count, externs_count, status = 0;
+    int opened = output_buffer_read_file(&text, ob_name);
+    if (!words)
+        exit_program_fatal_error();
+    output_buffer_init(&entries, 0);
+    output_buffer_init(&externs, 0);
+    if (!opened)
+        fprintf(stderr, "Error: unable to open file \"%s\".\n", ob_name);
+    else if (!parse_object_file(text.text, text.length, words, &ic, &dc, &base))
+        fprintf(stderr, "Error: \"%s\" is not a valid object file.\n", ob_name);
+    else if ((entries_count = binary_symbols_parse(ent_name, &entries)) < 0)
+        fprintf(stderr, "Error: \"%s\" is not a valid entries file.\n", ent_name);
+    else if ((externs_count = binary_symbols_parse(ext_name, &externs)) < 0)
+        fprintf(stderr, "Error: \"%s\" is not a valid externs file.\n", ext_name);
+    else {
+        output_buffer_init(&output, BINARY_HEADER_SIZE + (ic + dc) * BINARY_WORD_SIZE + entries.length + externs.length);
+        encode_binary_header((unsigned char*)output_buffer_extend(&output, BINARY_HEADER_SIZE), ic, dc, base, entries_count, externs_count);
+        encode_binary_words((unsigned char*)output_buffer_extend(&output, (ic + dc) * BINARY_WORD_SIZE), words, ic + dc);
+        output_buffer_append(&output, entries.text, entries.length);
+        output_buffer_append(&output, externs.text, externs.length);
+        status = output_buffer_write_file(&output, binary_name);
+        output_buffer_free(&output);
+    }
+    output_buffer_free(&entries);
+    output_buffer_free(&externs);
+    output_buffer_free(&text);
+    free(words);
+    free(ob_name);
+    free(ent_name);
+    free(ext_name);
+    free(binary_name);
+    return status;
+}
+
+/*
+ * write_symbols_file:
+ * writes the "count" symbol records starting at "records" to the ".ent" or
+ * ".ext" file named "filename", or removes that file if there are none, as
+ * the assembler does. returns 1 on success and 0 otherwise.
+ */
+static int write_symbols_file(const unsigned char *records, int count, char *filename){
+    output_buffer output;
+    int i, status;
+    if (!count){
+        remove(filename);
+        return 1;
+    }
+    output_buffer_init(&output, (size_t)count * (BINARY_NAME_SIZE + AWKWARD_LINE_SIZE));
+    for (i = 0; i < count; i++, records += BINARY_SYMBOL_SIZE){
+        char name[BINARY_NAME_SIZE];
+        int address = binary_symbol_read(records, name);
+        output_buffer_append_symbol(&output, name, address);
+    }
+    status = output_buffer_write_file(&output, filename);
+    output_buffer_free(&output);
+    return status;
+}
+
+/*
+ * convert_binary_to_text:
+ * converts the binary object file of the program "name" (given without an
+ * extension) to the ".ob", ".ent" and ".ext" files the assembler would have
+ * written for it. returns 1 on success, otherwise an error is printed and 0
+ * is returned.
+ */
+int convert_binary_to_text(char *name){
+    char *binary_name = add_extension(name, BINARY_EXTENSION);
+    binary_object object;
+    int status = 0;
+    if (binary_object_open(&object, binary_name)){
+        char *ob_name = add_extension(name, ".ob"), *ent_name = add_extension(name, ".ent");
+        char *ext_name = add_extension(name, ".ext");
+        int i, count = object.ic + object.dc;
+        word *words = (word*)malloc((count ? count : 1) * sizeof(word));
+        output_buffer output;
+        char *target;
+        if (!words)
+            exit_program_fatal_error();
+        for (i = 0; i < count; i++)
+            words[i].value = binary_object_word(&object, i);
+        output_buffer_init(&output, AWKWARD_LINE_SIZE - 1 + count * AWKWARD_LINE_SIZE);
+        target = output_buffer_extend(&output, AWKWARD_LINE_SIZE - 1 + count * AWKWARD_LINE_SIZE);
+        encode_awkward_word(object.ic, target);
+        target[AWKWARD_WORD_SIZE] = '\t';
+        encode_awkward_word(object.dc, target + AWKWARD_WORD_SIZE + 1);
+        encode_object_lines(target + AWKWARD_LINE_SIZE - 1, words, count, object.base);
+        status = output_buffer_write_file(&output, ob_name);
+        status = write_symbols_file(object.entries, object.entries_count, ent_name) && status;
+        status = write_symbols_file(object.externs, object.externs_count, ext_name) && status;
+        output_buffer_free(&output);
+        binary_object_close(&object);
+        free(words);
+        free(ob_name);
+        free(ent_name);
+        free(ext_name);
+    }
+    free(binary_name);
+    return status;
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef BINARY_OBJECT_H
+#define BINARY_OBJECT_H
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include "word.h"
+    #include "linked_list.h"
+    #include "output_buffer.h"
+
+    /*
+     * the binary object file layout, all numbers are unsigned 16 bits in little
+     * endian order: the header holds "BINARY_MAGIC", "BINARY_VERSION", IC, DC, the
+     * base address C, and the number of entries and externs. it is followed by the
+     * IC + DC memory words, then by the entries and externs tables, whose records
+     * hold a null padded symbol name and its address.
+     */
+    #define BINARY_MAGIC "AWOB"
+    #define BINARY_MAGIC_SIZE 4
+    #define BINARY_VERSION 1
+    #define BINARY_HEADER_SIZE (BINARY_MAGIC_SIZE + 6 * BINARY_WORD_SIZE)
+    #define BINARY_WORD_SIZE 2
+    #define BINARY_NAME_SIZE (MAX_NAME_SIZE + 1)
+    #define BINARY_SYMBOL_SIZE (BINARY_NAME_SIZE + BINARY_WORD_SIZE)
+    /*the extension of binary object files*/
+    #define BINARY_EXTENSION ".obb"
+
+    /*
+     * a binary object file loaded to memory: "data" holds the file's "size"
+     * bytes, "ic", "dc", "base", "entries_count" and "externs_count" are read
+     * from its header, "words", "entries" and "externs" point to its sections.
+     */
+    typedef struct binary_object {
+        const unsigned char *data;
+        size_t size;
+        int ic;
+        int dc;
+        int base;
+        int entries_count;
+        int externs_count;
+        const unsigned char *words;
+        const unsigned char *entries;
+        const unsigned char *externs;
+    } binary_object;
+
+    void encode_binary_header(unsigned char*, int, int, int, int, int);
+    void encode_binary_words(unsigned char*, const word*, int);
+    void binary_symbols_append(output_buffer*, char*, int);
+    int binary_symbols_parse(char*, output_buffer*);
+    int binary_symbol_read(const unsigned char*, char*);
+    int binary_object_open(binary_object*, char*);
+    void binary_object_close(binary_object*);
+    int binary_object_word(const binary_object*, int);
+    int binary_object_entry(const binary_object*, int, char*);
+    int binary_object_extern(const binary_object*, int, char*);
+    int convert_text_to_binary(char*);
+    int convert_binary_to_text(char*);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,396 @@
+#include "disassembler.h"
+
+/*
+ * This module turns the output files of an assembled program back into source
+ * code which the assembler translates to the same files. the ".ob" file is
+ * read through the "object_reader" module: each instruction word is split into
+ * its opcode and addressing types with the "isa" module's decoding macros, and
+ * the operand words that follow it are decoded according to these types. the
+ * symbols are restored from the ".ent" and ".ext" files: extern operands are
+ * found by their addresses in the ".ext" file, and labels are given to the
+ * addresses in the ".ent" file. data addresses used as operands that are not
+ * entries get generated labels. the data section has no information about the
+ * directives it was defined by, so it is written as ".data" lines, except for
+ * the structs used by ".struct" operands, which must be defined as such.
+ * the decoding is done twice: the first time only finds the data addresses
+ * that need labels, and the second writes the source. the examples' correct
+ * inputs are kept with their output files and the sources disassembled from
+ * those (the "Correct_Input_*.dis.as" files), which assemble to the same files.
+ */
+
+/*
+ * the state of a file being disassembled: "reader" holds its object file, the
+ * number of words is "count", and their values are in "values". for each memory
+ * index, "labels" holds the label's name (empty if none), "externs" the name of
+ * the extern symbol used by the word (NULL if none) and "structs" marks the
+ * data labels used by ".struct" operands. "status" is set to 0 when the files
+ * cannot be expressed as source code.
+ */
+typedef struct disassembly {
+    object_reader reader;
+    int count;
+    int values[AWKWARD_VALUES];
+    char labels[AWKWARD_VALUES][BINARY_NAME_SIZE];
+    const char *externs[AWKWARD_VALUES];
+    char structs[AWKWARD_VALUES];
+    int status;
+} disassembly;
+
+/*
+ * memory_index:
+ * returns the memory index of "address" in the file of "state", or -1 if the
+ * file has no word at that address.
+ */
+static int memory_index(disassembly *state, int address){
+    int index = (address - state->reader.base) & (AWKWARD_VALUES - 1);
+    return (address >= 0 && address < AWKWARD_VALUES && index < state->count) ? index : -1;
+}
+
+/*
+ * is_symbol_name:
+ * returns 1 if "name" is the label of any memory index or the name of an
+ * extern symbol in "table" of "count" records, 0 otherwise.
+ */
+static int is_symbol_name(disassembly *state, output_buffer *table, int count, char *name){
+    int i;
+    for (i = 0; i < state->count; i++)
+        if (!strcmp(state->labels[i], name))
+            return 1;
+    for (i = 0; i < count; i++)
+        if (!strcmp(table->text + (size_t)i * BINARY_SYMBOL_SIZE, name))
+            return 1;
+    return 0;
+}
+
+/*
+ * name_data_labels:
+ * gives a label to every data address used as an operand which is not an
+ * entry: "D" followed by the address, with more "D"s added in front if that
+ * name is already taken by another symbol in the file.
+ */
+static void name_data_labels(disassembly *state, char *used, output_buffer *externs, int externs_count){
+    int i;
+    for (i = 0; i < state->count; i++)
+        if (used[i] && !state->labels[i][0]){
+            char name[BINARY_NAME_SIZE];
+            int length = sprintf(name, "D%d", state->reader.base + i);
+            while (is_symbol_name(state, externs, externs_count, name) && length < MAX_NAME_SIZE - 1){
+                memmove(name + 1, name, ++length);
+                name[0] = 'D';
+            }
+            strcpy(state->labels[i], name);
+        }
+}
+
+/*
+ * data_operand:
+ * finds the memory index of the data label whose address is encoded in the
+ * operand word "value", marks it as "used" and as a struct if "is_struct" is
+ * set. only the 8 lowest bits of the address fit in the word, so the address
+ * is the one in the data section that matches them. returns the index, or -1
+ * if there is no such address.
+ */
+static int data_operand(disassembly *state, int value, int is_struct, char *used){
+    int data_start = state->reader.ic, first = state->reader.base + data_start;
+    int index = data_start + (((value >> 2) - first) & 255);
+    if ((value & 3) != 2 || index >= state->count)
+        return -1;
+    used[index] = 1;
+    if (is_struct)
+        state->structs[index] = 1;
+    return index;
+}
+
+/*
+ * append_operand:
+ * decodes the operand of addressing type "type" whose words start at memory
+ * index "index", "is_input" indicates if it is the input operand. if "output"
+ * is not NULL, the operand is appended to it. returns the number of words the
+ * operand occupies, or 0 if they cannot be decoded.
+ */
+static int append_operand(disassembly *state, int type, int index, int is_input, char *used, output_buffer *output){
+    int value = state->values[index], target;
+    char text[2 * BINARY_NAME_SIZE];
+    if (type == IMMEDIATE){
+        int number = (value >> 2) & 255;
+        if (value & 3)
+            return 0;
+        sprintf(text, "#%d", number > 127 ? number - 256 : number);
+    }
+    else if (type == REGISTER){
+        const isa_register *reg = isa_register_at(is_input ? DECODE_INPUT_REGISTER(value) : DECODE_OUTPUT_REGISTER(value));
+        if (!reg || value != ENCODE_REGISTER(reg->code, is_input))
+            return 0;
+        strcpy(text, reg->name);
+    }
+    else if (type == ABSOLUTE && state->externs[index]){
+        if (value != 1)
+            return 0;
+        strcpy(text, state->externs[index]);
+    }
+    else {
+        if ((target = data_operand(state, value, type == STRUCT, used)) < 0
+                || (type == STRUCT && (index + 1 >= state->reader.ic || state->values[index + 1] & 3)))
+            return 0;
+        if (type == STRUCT)
+            sprintf(text, "%s.%d", state->labels[target], state->values[index + 1] >> 2);
+        else strcpy(text, state->labels[target]);
+    }
+    if (output)
+        output_buffer_append_string(output, text);
+    return isa_operand_words(type);
+}
+
+/*
+ * append_instruction:
+ * decodes the instruction whose word is at memory index "index", and appends
+ * its line to "output" unless it is NULL. returns the number of words the
+ * instruction occupies, or 0 if they cannot be decoded as an instruction.
+ */
+static int append_instruction(disassembly *state, int index, char *used, output_buffer *output){
+    int value = state->values[index], words = 1, count;
+    int input_type = DECODE_INPUT_TYPE(value), output_type = DECODE_OUTPUT_TYPE(value);
+    const isa_instruction *data = isa_instruction_at(DECODE_OPCODE(value));
+    if ((value & 3) || (!data->input_modes && input_type) || (!data->output_modes && output_type)
+            || (data->input_modes && !IS_MODE_ALLOWED(data->input_modes, input_type))
+            || (data->output_modes && !IS_MODE_ALLOWED(data->output_modes, output_type)))
+        return 0;
+    if (output){
+        if (state->labels[index][0]){
+            output_buffer_append_string(output, state->labels[index]);
+            output_buffer_append(output, ": ", 2);
+        }
+        output_buffer_append_string(output, data->name);
+    }
+    if (data->input_modes && data->output_modes && input_type == REGISTER && output_type == REGISTER){
+        const isa_register *first, *second;
+        if (index + 1 >= state->reader.ic)
+            return 0;
+        first = isa_register_at(DECODE_INPUT_REGISTER(state->values[index + 1]));
+        second = isa_register_at(DECODE_OUTPUT_REGISTER(state->values[index + 1]));
+        if (!first || !second
+                || state->values[index + 1] != (ENCODE_REGISTER(first->code, 1) | ENCODE_REGISTER(second->code, 0)))
+            return 0;
+        if (output){
+            output_buffer_append_char(output, ' ');
+            output_buffer_append_string(output, first->name);
+            output_buffer_append(output, ", ", 2);
+            output_buffer_append_string(output, second->name);
+        }
+        words++;
+    }
+    else {
+        if (data->input_modes){
+            if (output) output_buffer_append_char(output, ' ');
+            if (index + words >= state->reader.ic
+                    || !(count = append_operand(state, input_type, index + words, 1, used, output)))
+                return 0;
+            words += count;
+        }
+        if (data->output_modes){
+            if (output) output_buffer_append_string(output, data->input_modes ? ", " : " ");
+            if (index + words >= state->reader.ic
+                    || !(count = append_operand(state, output_type, index + words, 0, used, output)))
+                return 0;
+            words += count;
+        }
+    }
+    if (output) output_buffer_append_char(output, '\n');
+    return words;
+}
+
+/*
+ * decode_instructions:
+ * decodes all the instructions, appending their lines to "output" unless it
+ * is NULL. the labels of the instructions must be at the beginning of one.
+ * returns 1 on success and 0 if the instructions section cannot be decoded.
+ */
+static int decode_instructions(disassembly *state, char *used, output_buffer *output){
+    int index = 0, words = 1, i;
+    while (index < state->reader.ic && words){
+        if ((words = append_instruction(state, index, used, output)))
+            for (i = index + 1; i < index + words; i++)
+                if (state->labels[i][0])
+                    words = 0;
+        index += words;
+    }
+    return words != 0;
+}
+
+/*
+ * append_struct:
+ * appends the ".struct" definition starting at memory index "index": its number,
+ * followed by a string which ends with a 0 word. returns the number of words it
+ * occupies, or 0 if the words that follow the number are not a string, or a
+ * label points inside it.
+ */
+static int append_struct(disassembly *state, int index, output_buffer *output){
+    int end = index + 1, i;
+    char number[12];
+    while (end < state->count && state->values[end] != 0){
+        int c = state->values[end];
+        if (c < ' ' || c > '~' || c == '\"' || state->labels[end][0])
+            return 0;
+        end++;
+    }
+    if (end == state->count)
+        return 0;
+    sprintf(number, "%d", (state->values[index] ^ 512) - 512);
+    output_buffer_append_string(output, ".struct ");
+    output_buffer_append_string(output, number);
+    output_buffer_append(output, ", \"", 3);
+    for (i = index + 1; i < end; i++)
+        output_buffer_append_char(output, (char)state->values[i]);
+    output_buffer_append(output, "\"\n", 2);
+    return end + 1 - index;
+}
+
+/*
+ * append_data:
+ * appends the definitions of the data section to "output": each struct used by
+ * a ".struct" operand as a ".struct" line, and the rest of the words as ".data"
+ * lines, which are split so every label is at the beginning of one. returns 1
+ * on success and 0 if a struct cannot be written.
+ */
+static int append_data(disassembly *state, output_buffer *output){
+    int index = state->reader.ic, values = 0, words;
+    while (index < state->count){
+        char number[12];
+        if (state->labels[index][0] || state->structs[index] || values == DATA_VALUES_PER_LINE){
+            if (values)
+                output_buffer_append_char(output, '\n');
+            values = 0;
+        }
+        if (!values && state->labels[index][0]){
+            output_buffer_append_string(output, state->labels[index]);
+            output_buffer_append(output, ": ", 2);
+        }
+        if (state->structs[index]){
+            if (!(words = append_struct(state, index, output)))
+                return 0;
+            index += words;
+            continue;
+        }
+        output_buffer_append_string(output, values ? ", " : ".data ");
+        sprintf(number, "%d", (state->values[index] ^ 512) - 512);
+        output_buffer_append_string(output, number);
+        values++;
+        index++;
+    }
+    if (values)
+        output_buffer_append_char(output, '\n');
+    return 1;
+}
+
+/*
+ * load_symbols:
+ * reads the ".ent" and ".ext" files of the program "name" in their order into
+ * the empty tables "entries" and "externs", and places their names at their memory indexes.
+ * returns 1 on success, or 0 if a symbol's address is not in the file, or an
+ * entry is not at the beginning of a word's line.
+ */
+static int load_symbols(disassembly *state, char *name, output_buffer *entries, int *entries_count,
+        output_buffer *externs, int *externs_count){
+    char *filename = (char*)malloc(strlen(name) + 5);
+    int i, index, status = 1;
+    if (!filename)
+        exit_program_fatal_error();
+    sprintf(filename, "%s.ent", name);
+    *entries_count = binary_symbols_parse(filename, entries);
+    sprintf(filename, "%s.ext", name);
+    *externs_count = binary_symbols_parse(filename, externs);
+    free(filename);
+    if (*entries_count < 0 || *externs_count < 0)
+        return 0;
+    for (i = 0; i < *externs_count; i++){
+        char symbol[BINARY_NAME_SIZE];
+        const unsigned char *record = (unsigned char*)externs->text + (size_t)i * BINARY_SYMBOL_SIZE;
+        if ((index = memory_index(state, binary_symbol_read(record, symbol))) < 0 || index >= state->reader.ic)
+            status = 0;
+        else state->externs[index] = (const char*)record;
+    }
+    for (i = 0; i < *entries_count; i++){
+        const unsigned char *record = (unsigned char*)entries->text + (size_t)i * BINARY_SYMBOL_SIZE;
+        char symbol[BINARY_NAME_SIZE];
+        if ((index = memory_index(state, binary_symbol_read(record, symbol))) < 0 || state->labels[index][0])
+            status = 0;
+        else strcpy(state->labels[index], symbol);
+    }
+    return status;
+}
+
+/*
+ * append_declarations:
+ * appends an ".extern" line for every extern symbol used, in the order they
+ * first appear in the ".ext" file, and an ".entry" line for every entry, in
+ * the order of the ".ent" file, which the assembler keeps.
+ */
+static void append_declarations(output_buffer *output, output_buffer *entries, int entries_count,
+        output_buffer *externs, int externs_count){
+    int i, j;
+    for (i = 0; i < externs_count; i++){
+        const char *symbol = externs->text + (size_t)i * BINARY_SYMBOL_SIZE;
+        for (j = 0; j < i && strcmp(symbol, externs->text + (size_t)j * BINARY_SYMBOL_SIZE); j++)
+            ;
+        if (j == i){
+            output_buffer_append_string(output, ".extern ");
+            output_buffer_append_string(output, symbol);
+            output_buffer_append_char(output, '\n');
+        }
+    }
+    for (i = 0; i < entries_count; i++){
+        output_buffer_append_string(output, ".entry ");
+        output_buffer_append_string(output, entries->text + (size_t)i * BINARY_SYMBOL_SIZE);
+        output_buffer_append_char(output, '\n');
+    }
+}
+
+/*
+ * disassemble_file:
+ * disassembles the output files of the program "name" (given without an
+ * extension) into the source file named "name" followed by DISASSEMBLY_EXTENSION.
+ * returns 1 on success, otherwise an error is printed and 0 is returned.
+ */
+int disassemble_file(char *name){
+    disassembly *state = (disassembly*)calloc(1, sizeof(disassembly));
+    output_buffer entries, externs, output;
+    int entries_count = 0, externs_count = 0, i;
+    char used[AWKWARD_VALUES] = {0};
+    if (!state)
+        exit_program_fatal_error();
+    if (!object_reader_open(&state->reader, name)){
+        free(state);
+        return 0;
+    }
+    output_buffer_init(&entries, 0);
+    output_buffer_init(&externs, 0);
+    state->count = state->reader.ic + state->reader.dc;
+    state->status = state->count <= AWKWARD_VALUES;
+    for (i = 0; state->status && i < state->count; i++)
+        state->status = (state->values[i] = object_reader_word(&state->reader, (state->reader.base + i) & (AWKWARD_VALUES - 1))) >= 0;
+    state->status = state->status && load_symbols(state, name, &entries, &entries_count, &externs, &externs_count)
+            && decode_instructions(state, used, NULL);
+    output_buffer_init(&output, 0);
+    if (state->status){
+        name_data_labels(state, used, &externs, externs_count);
+        append_declarations(&output, &entries, entries_count, &externs, externs_count);
+        state->status = decode_instructions(state, used, &output) && append_data(state, &output);
+    }
+    if (state->status){
+        char *filename = (char*)malloc(strlen(name) + strlen(DISASSEMBLY_EXTENSION) + 1);
+        if (!filename)
+            exit_program_fatal_error();
+        strcpy(filename, name);
+        strcat(filename, DISASSEMBLY_EXTENSION);
+        state->status = output_buffer_write_file(&output, filename);
+        free(filename);
+    }
+    else fprintf(error_output(), "Error: the output files of \"%s\" cannot be disassembled.\n", name);
+    i = state->status;
+    output_buffer_free(&output);
+    output_buffer_free(&entries);
+    output_buffer_free(&externs);
+    object_reader_close(&state->reader);
+    free(state);
+    return i;
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#ifndef DISASSEMBLER_H
+#define DISASSEMBLER_H
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include "isa.h"
+    #include "object_reader.h"
+
+    /*the extension added to a program's name for its disassembled source*/
+    #define DISASSEMBLY_EXTENSION ".dis.as"
+    /*the maximum number of values in a ".data" line of the disassembled source*/
+    #define DATA_VALUES_PER_LINE 6
+
+    int disassemble_file(char*);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,197 @@
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#include "encoding_cache.h"
+
+/*
+ * This module implements a cache of encoded instruction lines for the first
+ * pass processor: an instruction line which has no label and whose operands
+ * are only registers and immediate values is always encoded to the same words,
+ * regardless of the file it appears in or the symbols defined in it, so once
+ * such a line has been processed, the words it was encoded to are stored here
+ * with the line's normalized text as the key. when the same text appears again,
+ * the words are copied to the instructions array without going through the
+ * whole line processing chain. unlike the symbol table, the cache is kept for
+ * the whole run of the program, and should be freed by the user when done.
+ * each thread has a cache of its own, kept for all the files it processes, so
+ * the threads processing files at the same time never wait for each other to
+ * search it. when a thread ends its cache is freed and its hits and misses are
+ * added to the totals, which are the only part shared by the threads.
+ */
+
+/*
+ * "cache_key": the key each thread's cache is stored under, created once by
+ * "key_once".
+ * "total_hits" and "total_misses": the hits and misses of the threads which
+ * ended, guarded by "totals_lock".
+ */
+static pthread_key_t cache_key;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static long total_hits = 0;
+static long total_misses = 0;
+static pthread_mutex_t totals_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * cache_hash_function:
+ * returns the bucket index for "key". lines that differ only in the order of
+ * their operands (like "mov r1, r2" and "mov r2, r1") are common, so unlike
+ * "default_hash_function", the characters' positions are mixed into the value.
+ */
+static unsigned int cache_hash_function(char *key){
+    unsigned int c, hash_value = 5381;
+    while((c = (unsigned char)*key++))
+        hash_value = hash_value * 33 + c;
+    return hash_value % CACHE_BUCKETS;
+}
+
+/*
+ * bucket_find:
+ * returns the entry of "key" in the bucket at "index" of "cache", or NULL if
+ * there is none.
+ */
+static cache_entry *bucket_find(encoding_cache *cache, char *key, unsigned int index){
+    cache_entry *curr = cache->buckets[index];
+    while (curr && strcmp(key, curr->key))
+        curr = curr->next;
+    return curr;
+}
+
+/*
+ * free_entries:
+ * frees all the entries of "cache".
+ */
+static void free_entries(encoding_cache *cache){
+    int i;
+    for (i = 0; i < CACHE_BUCKETS; i++){
+        cache_entry *curr = cache->buckets[i];
+        while (curr){
+            cache_entry *temp = curr;
+            curr = curr->next;
+            free(temp);
+        }
+    }
+}
+
+/*
+ * release_cache:
+ * adds the hits and misses of the cache "data" of a thread which ended to the
+ * totals, and frees it.
+ */
+static void release_cache(void *data){
+    encoding_cache *cache = (encoding_cache*)data;
+    pthread_mutex_lock(&totals_lock);
+    total_hits += cache->hits;
+    total_misses += cache->misses;
+    pthread_mutex_unlock(&totals_lock);
+    free_entries(cache);
+    free(cache);
+}
+
+/*
+ * create_cache_key:
+ * creates the key the threads' caches are stored under.
+ */
+static void create_cache_key(void){
+    if (pthread_key_create(&cache_key, release_cache))
+        exit_program_fatal_error();
+}
+
+/*
+ * thread_cache:
+ * returns the cache of the calling thread, which is created if it has none
+ * yet and "create" is not 0, otherwise NULL is returned.
+ */
+static encoding_cache *thread_cache(int create){
+    encoding_cache *cache;
+    pthread_once(&key_once, create_cache_key);
+    if (!(cache = (encoding_cache*)pthread_getspecific(cache_key)) && create){
+        if (!(cache = (encoding_cache*)calloc(1, sizeof(encoding_cache))))
+            return exit_program_fatal_error();
+        pthread_setspecific(cache_key, cache);
+    }
+    return cache;
+}
+
+/*
+ * encoding_cache_find:
+ * searches the calling thread's cache for "key" and returns a pointer to its
+ * entry, or NULL if the line has not been cached yet. the hits and misses
+ * counters are updated accordingly.
+ */
+cache_entry *encoding_cache_find(char *key){
+    encoding_cache *cache = thread_cache(1);
+    cache_entry *entry;
+    if ((entry = bucket_find(cache, key, cache_hash_function(key))))
+        cache->hits++;
+    else cache->misses++;
+    return entry;
+}
+
+/*
+ * encoding_cache_insert:
+ * stores a new entry with "key" and the "count" words in "words" in the
+ * calling thread's cache. the caller makes sure the key is shorter than
+ * CACHE_KEY_SIZE. nothing is done if the cache is full, "count" is out of
+ * range, or the key is already cached.
+ */
+void encoding_cache_insert(char *key, word *words, int count){
+    encoding_cache *cache = thread_cache(1);
+    cache_entry *entry;
+    unsigned int index = cache_hash_function(key);
+    if (count < 1 || count > MAX_CACHED_WORDS || cache->entries_count >= CACHE_MAX_ENTRIES || bucket_find(cache, key, index))
+        return;
+    entry = (cache_entry*)malloc(sizeof(cache_entry));
+    if (!entry){
+        exit_program_fatal_error();
+        return;
+    }
+    strcpy(entry->key, key);
+    memcpy(entry->words, words, count * sizeof(word));
+    entry->words_count = count;
+    entry->next = cache->buckets[index];
+    cache->buckets[index] = entry;
+    cache->entries_count++;
+}
+
+/*
+ * free_encoding_cache:
+ * frees the calling thread's cache and resets the counters. should be called
+ * once no other thread is using the cache.
+ */
+void free_encoding_cache(void){
+    encoding_cache *cache = thread_cache(0);
+    if (cache){
+        free_entries(cache);
+        free(cache);
+        pthread_setspecific(cache_key, NULL);
+    }
+    total_hits = 0;
+    total_misses = 0;
+}
+
+/*
+ * get_encoding_cache_hits:
+ * returns the number of lines which were found in the cache, by the calling
+ * thread and the threads which ended.
+ */
+long get_encoding_cache_hits(void){
+    encoding_cache *cache = thread_cache(0);
+    long count;
+    pthread_mutex_lock(&totals_lock);
+    count = total_hits + (cache ? cache->hits : 0);
+    pthread_mutex_unlock(&totals_lock);
+    return count;
+}
+
+/*
+ * get_encoding_cache_misses:
+ * returns the number of lines which were looked up and not found in the
+ * cache, by the calling thread and the threads which ended.
+ */
+long get_encoding_cache_misses(void){
+    encoding_cache *cache = thread_cache(0);
+    long count;
+    pthread_mutex_lock(&totals_lock);
+    count = total_misses + (cache ? cache->misses : 0);
+    pthread_mutex_unlock(&totals_lock);
+    return count;
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef ENCODING_CACHE_H
+#define ENCODING_CACHE_H
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include "word.h"
+    #include "error_handler.h"
+
+    /*the number of buckets in the cache: a prime number, like the symbol table's size*/
+    #define CACHE_BUCKETS 1021
+    /*the maximum number of lines the cache of a thread holds, new lines are not cached beyond it*/
+    #define CACHE_MAX_ENTRIES 4096
+    /*the maximum length of a cached line, as the maximum line width allowed*/
+    #define CACHE_KEY_SIZE 80
+    /*an instruction with no symbolic operands is encoded in up to 3 words*/
+    #define MAX_CACHED_WORDS 3
+
+    /*
+     * a cached line: "key" is the normalized text of an instruction line which
+     * has no label and no symbolic operands, "words" are the "words_count" words
+     * it was encoded to, and "next" points to the next entry in the same bucket.
+     */
+    typedef struct cache_entry {
+        char key[CACHE_KEY_SIZE];
+        word words[MAX_CACHED_WORDS];
+        int words_count;
+        struct cache_entry *next;
+    } cache_entry;
+
+    /*
+     * the cache of one thread: the hash table's "buckets" of entries lists,
+     * the number of lines cached ("entries_count"), and the numbers of
+     * successful ("hits") and unsuccessful ("misses") searches.
+     */
+    typedef struct encoding_cache {
+        cache_entry *buckets[CACHE_BUCKETS];
+        int entries_count;
+        long hits;
+        long misses;
+    } encoding_cache;
+
+    cache_entry *encoding_cache_find(char*);
+    void encoding_cache_insert(char*, word*, int);
+    void free_encoding_cache(void);
+    long get_encoding_cache_hits(void);
+    long get_encoding_cache_misses(void);
+
+#endif
\ No newline at end of file
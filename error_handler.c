@@ -1,11 +1,13 @@
-#include "error_handler.h"
+#include "assembler_context.h"
 
 /*
  * This module handles errors that might occur while processing
  * the input file. by "handle" I mean usually printing the error
  * to stderr in order to notify the user, while the file processing
  * modules are responsible for implementing the logic that handles
- * the error. an error will usually cause the program to not produce
+ * the error. the messages are printed to the error stream of the current
+ * assembler context (see "assembler_context"), stderr unless the file's
+ * messages are captured. an error will usually cause the program to not produce
  * an output, while a warning is issued only to notify a user of some
  * issues that might cause undefined behavior, but will allow the output
  * to be produced.
@@ -70,7 +72,9 @@ static const error_record warnings_list[] = {
  * the "errors_list", the message will also include the line number "line_count".
  */
 void print_error_string(int line_count, int error_number, char *str){
-    fprintf(stderr, "Error, line %d: \"%s\" %s\n", line_count, str, errors_list[error_number].text);
+    char text[DIAGNOSTIC_SIZE];
+    sprintf(text, "Error, line %d: \"%.*s\" %s", line_count, DIAGNOSTIC_QUOTE_SIZE, str, errors_list[error_number].text);
+    report_diagnostic(line_count, 0, error_number, text);
 }
 
 /*
@@ -79,7 +83,9 @@ void print_error_string(int line_count, int error_number, char *str){
  * the "errors_list", the message will also include the line number "line_count".
  */
 void print_error_char(int line_count, int error_number, char c){
-    fprintf(stderr, "Error, line %d: \'%c\' %s\n", line_count, c, errors_list[error_number].text);
+    char text[DIAGNOSTIC_SIZE];
+    sprintf(text, "Error, line %d: \'%c\' %s", line_count, c, errors_list[error_number].text);
+    report_diagnostic(line_count, 0, error_number, text);
 }
 
 /*
@@ -88,7 +94,9 @@ void print_error_char(int line_count, int error_number, char c){
  * the "errors_list", the message will also include the line number "line_count".
  */
 void print_error(int line_count, int error_number){
-    fprintf(stderr, "Error, line %d: %s\n", line_count, errors_list[error_number].text);
+    char text[DIAGNOSTIC_SIZE];
+    sprintf(text, "Error, line %d: %s", line_count, errors_list[error_number].text);
+    report_diagnostic(line_count, 0, error_number, text);
 }
 
 /*
@@ -97,7 +105,9 @@ void print_error(int line_count, int error_number){
  * the "warnings_list", the message will also include the line number "line_count".
  */
 void print_warning_string(int line_count, int warning_number, char *str){
-    fprintf(stderr, "Warning, line %d: \"%s\" %s\n", line_count, str, warnings_list[warning_number].text);
+    char text[DIAGNOSTIC_SIZE];
+    sprintf(text, "Warning, line %d: \"%.*s\" %s", line_count, DIAGNOSTIC_QUOTE_SIZE, str, warnings_list[warning_number].text);
+    report_diagnostic(line_count, 1, warning_number, text);
 }
 
 /*
@@ -106,7 +116,9 @@ void print_warning_string(int line_count, int warning_number, char *str){
  * the "warnings_list", the message will also include the line number "line_count".
  */
 void print_warning_int(int line_count, int warning_number, int value){
-    fprintf(stderr, "Warning, line %d: \"%d\" %s\n", line_count, value, warnings_list[warning_number].text);
+    char text[DIAGNOSTIC_SIZE];
+    sprintf(text, "Warning, line %d: \"%d\" %s", line_count, value, warnings_list[warning_number].text);
+    report_diagnostic(line_count, 1, warning_number, text);
 }
 
 /*
@@ -115,19 +127,89 @@ void print_warning_int(int line_count, int warning_number, int value){
  * the "warnings_list", the message will also include the line number "line_count".
  */
 void print_warning(int line_count, int warning_number){
-    fprintf(stderr, "Warning, line %d: %s\n", line_count, warnings_list[warning_number].text);
+    char text[DIAGNOSTIC_SIZE];
+    sprintf(text, "Warning, line %d: %s", line_count, warnings_list[warning_number].text);
+    report_diagnostic(line_count, 1, warning_number, text);
+}
+
+/*
+ * report_diagnostic:
+ * prints the diagnostic "text" on a line of its own, and adds it to the current
+ * context's diagnostics list when they are collected. "line_count" is the line
+ * it was found in, "is_warning" tells a warning from an error and "code" is its
+ * number in the errors or warnings list (0 for other diagnostics).
+ */
+void report_diagnostic(int line_count, int is_warning, int code, const char *text){
+    diagnostic_list *list = current_context()->diagnostics;
+    diagnostic *item;
+    fprintf(error_output(), "%s\n", text);
+    if (!list)
+        return;
+    if (list->count == list->capacity){
+        int capacity = list->capacity ? 2 * list->capacity : INITIAL_DIAGNOSTICS_CAPACITY;
+        diagnostic *temp = (diagnostic*)realloc(list->items, capacity * sizeof(diagnostic));
+        if (!temp){
+            exit_program_fatal_error();
+            return;
+        }
+        list->items = temp;
+        list->capacity = capacity;
+    }
+    item = list->items + list->count++;
+    item->line = line_count;
+    item->is_warning = is_warning;
+    item->code = code;
+    strncpy(item->text, text, DIAGNOSTIC_SIZE - 1);
+    item->text[DIAGNOSTIC_SIZE - 1] = '\0';
 }
 
 /*
  * exit_program_fatal_error:
- * exits the program when a fatal error occurs, usually when the environment is unable
- * to allocate new memory. the reason this function has a return type is that
+ * handles a fatal error, usually when the environment is unable to allocate new
+ * memory: if the current context has a recovery point (see "assembler"), the
+ * processing of the file is abandoned by jumping back to it, otherwise the
+ * program exits. the reason this function has a return type is that
  * some of the functions which might call it have one themselves, so in order
  * to avoid a warning printed by the compiler a return type has been added, so
  * the calling functions can use it.
  */
 void *exit_program_fatal_error(void){
+    assembler_context *context = current_context();
+    if (context->recovery){
+        fprintf(context->err, "Fatal Error: unable to allocate memory, stopped processing the file!\n\n");
+        longjmp(*context->recovery, 1);
+    }
     fprintf(stderr, "Fatal Error: unable to allocate memory, exiting program!\n\n");
     exit(EXIT_FAILURE);
     return NULL;
+}
+
+/*
+ * abandon_file:
+ * stops processing the current file, like "exit_program_fatal_error" but
+ * without a message of its own: by jumping back to the current context's
+ * recovery point if it has one, otherwise by exiting the program.
+ */
+void abandon_file(void){
+    assembler_context *context = current_context();
+    if (context->recovery)
+        longjmp(*context->recovery, 1);
+    exit(EXIT_FAILURE);
+}
+
+/*
+ * error_output:
+ * returns the stream the errors of the file being processed are printed to.
+ */
+FILE *error_output(void){
+    return current_context()->err;
+}
+
+/*
+ * status_output:
+ * returns the stream the status messages of the file being processed are
+ * printed to.
+ */
+FILE *status_output(void){
+    return current_context()->out;
 }
\ No newline at end of file
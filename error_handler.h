@@ -4,6 +4,32 @@
     #include <stdio.h>
     #include <stdlib.h>
     #include <string.h>
+
+    /*the maximum length of a diagnostic's text, and of the text quoted in it*/
+    #define DIAGNOSTIC_SIZE 256
+    #define DIAGNOSTIC_QUOTE_SIZE 128
+    /*the initial number of diagnostics allocated for a list, doubled as needed*/
+    #define INITIAL_DIAGNOSTICS_CAPACITY 16
+
+    /*
+     * an error or a warning reported while processing a file: the "line" it
+     * was found in (0 if it is not tied to a line), whether it "is_warning",
+     * its "code" in the errors or warnings list (0 if it is not listed) and
+     * its "text", as printed.
+     */
+    typedef struct diagnostic {
+        int line;
+        int is_warning;
+        int code;
+        char text[DIAGNOSTIC_SIZE];
+    } diagnostic;
+
+    /*a list of "count" diagnostics in "items", out of the "capacity" allocated*/
+    typedef struct diagnostic_list {
+        diagnostic *items;
+        int count;
+        int capacity;
+    } diagnostic_list;
 	
     void print_error_string(int, int, char*);
     void print_error_char(int, int, char);
@@ -11,7 +37,11 @@
     void print_warning_string(int, int, char*);
     void print_warning_int(int, int, int);
     void print_warning(int, int);
+    void report_diagnostic(int, int, int, const char*);
     void *exit_program_fatal_error(void);
+    void abandon_file(void);
+    FILE *error_output(void);
+    FILE *status_output(void);
 
 #endif
 
@@ -1,4 +1,4 @@
-#include "first_pass_processor.h"
+#include "assembler_context.h"
  
 /*
  * this module is responsible for processing the input file in the first pass.
@@ -32,53 +32,161 @@
  * the user about these lines, rather than trying to find each and every error present.
  * the processor, however, will continue processing the lines, even if one has been
  * detected to contain errors.
+ * instruction lines that have no label and only register and immediate operands
+ * are stored in the encoding cache (see "encoding_cache") once processed, so a
+ * line with the same text is encoded by copying the cached words.
  * if at any point the memory becomes full, the program will still process the next
  * lines, however, no new words will be saved, and no output files will be produced
  * since the program might cause errors when the imaginary CPU tries to run it.
  */
 
  /*
-  * "intput_as": is a pointer to a file accessible to all the functions in this
-  * file, which represents the input file for the assembler.
-  * "line_count" represents the line counter, the reason it's set as a global
-  * variable in this file, is to allow easy access for error reporting functions,
-  * instead of passing it down a function chain, making the code less readable.
+  * the state of the file being processed (see "first_pass_state" in the header)
+  * is held by the assembler context, which is passed down the chain of functions
+  * as "context" rather than looked up for each character. the input file is read
+  * into memory, so the functions in this file read their characters from memory
+  * instead of going through the stdio stream for each of them. the line counter
+  * is kept in the state rather than passed down a function chain, to allow easy
+  * access for error reporting functions, making the code more readable.
   */
-static FILE *intput_as = NULL;
-static int line_count = 0;
 
 /*
  * load_input_file:
- * opens the ".as" input file named "filename", initializes line_count to 0.
- * returns a pointer to a FILE, where all input is directed for the functions
- * in this module. should be called when starting to process a new file.
+ * opens the ".as" input file named "filename", reads all of its contents into
+ * "input" and closes it, initializes line_count to 0. returns 1 if the file
+ * was read successfully, 0 if it could not be opened. the contents count
+ * against the file's memory limit, and reading stops once they would go
+ * over it. should be called when starting to process a new file.
  */
-FILE *load_input_file(char *filename){
-   intput_as = fopen(filename, "r");
-   line_count = 0;
-   return intput_as;
+int load_input_file(assembler_context *context, char *filename){
+    size_t capacity = INPUT_CHUNK_SIZE, read_count;
+    FILE *file = fopen(filename, "r");
+    input_buffer *input = &context->first_pass.input;
+    context->first_pass.line_count = 0;
+    if (!file)
+        return 0;
+    input->text = (char*)malloc(capacity);
+    input->length = 0;
+    while (input->text && (read_count = fread(input->text + input->length, 1, capacity - input->length, file)) > 0)
+        if ((input->length += read_count) == capacity){
+            char *temp;
+            if (!within_memory_limit(capacity *= 2))
+                break;
+            if (!(temp = (char*)realloc(input->text, capacity))){
+                fclose(file);
+                exit_program_fatal_error();
+            }
+            input->text = temp;
+        }
+    fclose(file);
+    if (!input->text)
+        exit_program_fatal_error();
+    count_allocation(capacity);
+    input->position = 0;
+    input->time_check = next_time_check(0, input->length);
+    input->pushed_count = 0;
+    input->eof_flag = 0;
+    return 1;
+}
+
+/*
+ * load_input_text:
+ * like "load_input_file", but copies the "length" characters of "text" as the
+ * input, for sources which are not read from a file.
+ */
+void load_input_text(assembler_context *context, const char *text, size_t length){
+    input_buffer *input = &context->first_pass.input;
+    context->first_pass.line_count = 0;
+    count_allocation(length);
+    input->text = (char*)malloc(length ? length : 1);
+    if (!input->text)
+        exit_program_fatal_error();
+    memcpy(input->text, text, length);
+    input->length = length;
+    input->position = 0;
+    input->time_check = next_time_check(0, length);
+    input->pushed_count = 0;
+    input->eof_flag = 0;
+}
+
+/*
+ * get_line_count:
+ * returns the number of lines read from the input, which is kept after the
+ * input is closed, until the next input is loaded.
+ */
+int get_line_count(assembler_context *context){
+    return context->first_pass.line_count;
 }
 
 /*
  * close_input_file:
- * should be called when processing is done to close the file an set its value
- * to NULL, in case another file needs to be processed.
+ * should be called when processing is done to free the file's contents and
+ * reset "input", in case another file needs to be processed.
  */
-void close_input_file(void){
-    fclose(intput_as);
-    intput_as = NULL;
+void close_input_file(assembler_context *context){
+    input_buffer *input = &context->first_pass.input;
+    free(input->text);
+    input->text = NULL;
+    input->length = 0;
+    input->position = 0;
+    input->time_check = 0;
+    input->pushed_count = 0;
+    input->eof_flag = 0;
+}
+
+/*
+ * read_char:
+ * the equivalent of "getc" for "input": returns the last character returned
+ * to the input if there is one, otherwise the next character in the file, or
+ * EOF (marking the end of file flag) if all the characters have been read.
+ * once the position of the next time check is reached, the time the file
+ * took is checked, which bounds even a file of one long line.
+ */
+static int read_char(assembler_context *context){
+    input_buffer *input = &context->first_pass.input;
+    if (input->pushed_count)
+        return input->pushed[--input->pushed_count];
+    if (input->position < input->time_check)
+        return (unsigned char)input->text[input->position++];
+    if (input->position < input->length){
+        input->time_check = next_time_check(input->position, input->length);
+        check_time_limit();
+        return (unsigned char)input->text[input->position++];
+    }
+    input->eof_flag = 1;
+    return EOF;
+}
+
+/*
+ * unread_char:
+ * the equivalent of "ungetc" for "input": returns "c" to the input so it
+ * would be the next character read, and clears the end of file flag. returning
+ * EOF does nothing. the common case, returning the character that was just read,
+ * only moves the position back, other characters (like a line break returned
+ * after an error) are kept in the "pushed" stack.
+ */
+static void unread_char(assembler_context *context, int c){
+    input_buffer *input = &context->first_pass.input;
+    if (c == EOF)
+        return;
+    c = (unsigned char)c;
+    input->eof_flag = 0;
+    if (!input->pushed_count && input->position > 0 && (unsigned char)input->text[input->position - 1] == c)
+        input->position--;
+    else if (input->pushed_count < MAX_PUSHED_CHARS)
+        input->pushed[input->pushed_count++] = c;
 }
 
 /*
  * skip_whites:
  * skips spaces and tabs, returns the first non space nor tab char
- * it reads to the caller and to the file "intput_as".
+ * it reads to the caller and to the input.
  */
-static int skip_whites(void){
+static int skip_whites(assembler_context *context){
     int c;
-    while((c = getc(intput_as)) == '\t' || c == ' ')
+    while((c = read_char(context)) == '\t' || c == ' ')
         ;
-    ungetc(c, intput_as);
+    unread_char(context, c);
     return c;
 }
 
@@ -87,9 +195,9 @@ static int skip_whites(void){
  * it skips and consumes all the characters until a line break or EOF is
  * detected (and put back into the input file).
  */
-static int skip_line(void){
+static int skip_line(assembler_context *context){
     int c;
-    while((c = getc(intput_as)) != '\n' && c != EOF)
+    while((c = read_char(context)) != '\n' && c != EOF)
         ;
     return c;
 }
@@ -99,11 +207,11 @@ static int skip_line(void){
  * skips spaces and tabs, then reads the next char, returns it to the
  * user and the input file.
  */
-static int peek_next_char(void){
+static int peek_next_char(assembler_context *context){
     int c;
-    skip_whites();
-    c = getc(intput_as);
-    ungetc(c, intput_as);
+    skip_whites(context);
+    c = read_char(context);
+    unread_char(context, c);
     return c;
 }
 
@@ -119,18 +227,20 @@ static int peek_next_char(void){
  * through a linebreak.
  * this function is used to read the operands of ".entry"/".extern" directives, instructions
  * have their own operand processing functions.
+ * "string" has "MAX_BUFFER_SIZE" cells, a longer string is read through but only
+ * its beginning is saved (it's too long to be legal anyway).
  */
-static int read_next_string(char *string){
-    int c, chars_count;
+static int read_next_string(assembler_context *context, char *string){
+    int c, chars_count = 0;
     char *p = string;
-    while((c = getc(intput_as)) != EOF && c != ':' && c != '\n' && c != ' ' && c != '\t'){
-        chars_count++;
-        *p++ = c;
+    while((c = read_char(context)) != EOF && c != ':' && c != '\n' && c != ' ' && c != '\t'){
+        if (chars_count++ < MAX_BUFFER_SIZE - 2)
+            *p++ = c;
     }
     if (c == ':') *p++ = c;
-    else ungetc(c, intput_as);
+    else unread_char(context, c);
     *p = '\0';
-    skip_whites();
+    skip_whites(context);
     return chars_count;
 }
 
@@ -164,23 +274,23 @@ static int read_next_string(char *string){
  * a number, this why "atoi" is not used instead. the function returns any
  * non digit character it has read through last to the input file.
  */
-static int read_next_number(int *dest){
+static int read_next_number(assembler_context *context, int *dest){
     int sign = 1, current_number = 0, status = 0;
-    int c = getc(intput_as), next_c = getc(intput_as);
-    ungetc(next_c, intput_as);
+    int c = read_char(context), next_c = read_char(context);
+    unread_char(context, next_c);
     if (c == '+' && isdigit(next_c)) sign = 1;
     else if (c == '-' && isdigit(next_c)) sign = -1;
     else if(!isdigit(c)){
-        ungetc(c, intput_as);
+        unread_char(context, c);
         return status;
     }
     else
-        ungetc(c, intput_as);
-    while(isdigit(c = getc(intput_as))){
+        unread_char(context, c);
+    while(isdigit(c = read_char(context))){
         current_number = 10 * current_number + (c - '0');
         status++;
     }	
-    ungetc(c, intput_as);
+    unread_char(context, c);
     *dest = sign * current_number;
     return status;
 }
@@ -208,27 +318,27 @@ static char *shorten_string(char *string){
  * 30 characters (excluding '\0'). 0 is returned in case the label is
  * not legal.
  */
-static int is_legal_label(char *label, int is_new_label){
+static int is_legal_label(assembler_context *context, char *label, int is_new_label){
     int i, length = strlen(label);
     if (!isalpha(label[0])){
-        print_error_string(line_count, 12, label);
+        print_error_string(context->first_pass.line_count, 12, label);
         return 0;
     }
     if (is_new_label && (label[length - 1] != ':')){
-        print_error_string(line_count, 4, label);
+        print_error_string(context->first_pass.line_count, 4, label);
         return 0;
     }
     if ((!is_new_label && length > 30) || (is_new_label && length > 31)){
-        print_error_string(line_count, 11, shorten_string(label));
+        print_error_string(context->first_pass.line_count, 11, shorten_string(label));
         return 0;        
     }
     for(i = 1; i < length - 1 ; i++)
         if(!isalpha(label[i]) && !isdigit(label[i])){
-            print_error_string(line_count, 13, label);
+            print_error_string(context->first_pass.line_count, 13, label);
             return 0;
     }
     if (!is_new_label && length > 1 && !isalpha(label[length -1]) && !isdigit(label[length - 1])){
-        print_error_string(line_count, 13, label);
+        print_error_string(context->first_pass.line_count, 13, label);
         return 0;
     }
     return 1;
@@ -253,8 +363,8 @@ static char *remove_colon(char *src){
  * checks if a line is a comment (first non tab/space character is ';')
  * or empty (next character is line break), returns 1 if so, 0 otherwise.
  */
-static int is_comment_or_empty_line(void){
-    int c = skip_whites();
+static int is_comment_or_empty_line(assembler_context *context){
+    int c = skip_whites(context);
     if (c == '\n' || c == ';'){
         return 1;   
     }
@@ -262,6 +372,85 @@ static int is_comment_or_empty_line(void){
         return 0;
 }
 
+/*
+ * read_line_key:
+ * copies the rest of the current line (which starts at a non space character)
+ * to "key" without consuming it, normalized so lines that differ only in the
+ * spaces and tabs between their words share the same key: each sequence of
+ * spaces and tabs is replaced by one space, and trailing ones are removed.
+ * returns 0 if the line can not be in the encoding cache: it's a directive,
+ * includes a colon (so it might have a label), is too long or characters were
+ * returned to the input, 1 otherwise.
+ */
+static int read_line_key(assembler_context *context, char *key){
+    input_buffer *input = &context->first_pass.input;
+    int c, length = 0;
+    size_t i = input->position;
+    if (input->pushed_count || i >= input->length || input->text[i] == '.')
+        return 0;
+    while (i < input->length && (c = input->text[i++]) != '\n'){
+        if (c == ':' || c == '\0' || length == CACHE_KEY_SIZE - 1)
+            return 0;
+        if (c == ' ' || c == '\t'){
+            while (i < input->length && (input->text[i] == ' ' || input->text[i] == '\t'))
+                i++;
+            c = ' ';
+        }
+        key[length++] = c;
+    }
+    if (length && key[length - 1] == ' ')
+        length--;
+    key[length] = '\0';
+    return length > 0;
+}
+
+/*
+ * store_cached_words:
+ * inserts the words of a cached line "entry" into the instructions array
+ * and skips the line, as if the line was processed by "process_instruction".
+ */
+static void store_cached_words(assembler_context *context, cache_entry *entry){
+    int i;
+    for (i = 0; i < entry->words_count; i++)
+        instructions_array_insert(context, entry->words[i]);
+    skip_line(context);
+}
+
+/*
+ * is_cacheable_operand:
+ * checks if an operand "op" of a line that has been processed successfully
+ * can be part of a cached line: it has to be a register, or a number which
+ * did not cause a warning to be printed.
+ */
+static int is_cacheable_operand(operand *op){
+    int value;
+    if (op->type == REGISTER)
+        return 1;
+    if (op->type != IMMEDIATE)
+        return 0;
+    value = atoi(op->text + 1);
+    return value <= 127 && value >= -128;
+}
+
+/*
+ * cache_instruction_line:
+ * stores the words of an instruction line which was processed successfully
+ * in the encoding cache under "cache_key", starting at "first_index" in the
+ * instructions array, if the line's operands allow it (see "is_cacheable_operand").
+ * nothing is cached if the memory became full.
+ */
+static void cache_instruction_line(assembler_context *context, char *cache_key, const isa_instruction *data, operand *op1, operand *op2, int first_index){
+    int i, count = get_ic(context) - first_index;
+    word words[MAX_CACHED_WORDS];
+    if (get_memmory_full_flag(context) || count > MAX_CACHED_WORDS)
+        return;
+    if ((data->input_modes && !is_cacheable_operand(op1)) || (data->output_modes && !is_cacheable_operand(op2)))
+        return;
+    for (i = 0; i < count; i++)
+        words[i] = instructions_array_get_index(context, first_index + i);
+    encoding_cache_insert(cache_key, words, count);
+}
+
 /*
  * is_command:
  * checks if the "str" is a key for a node in the symbols table, and stores
@@ -269,8 +458,8 @@ static int is_comment_or_empty_line(void){
  * an instruction ("mov", "lea", etc..) or a directive (e.g. ".data"),
  * 1 is returned, 0 otherwise.
  */
-static int is_command(char *str, node **symbol){
-    *symbol = find_symbol(str);
+static int is_command(assembler_context *context, char *str, node **symbol){
+    *symbol = find_symbol(context, str);
     if (*symbol && ((*symbol)->type == INST || (*symbol)->type == DIRECT))
         return 1;
     return 0;
@@ -281,13 +470,13 @@ static int is_command(char *str, node **symbol){
  * checks and reports the relevant error which "pre_process_line" has encountered
  * and returned a status of 0. the input parameters are set by the calling function.
  */
-static void pre_process_line_error_check(char *str1, char *str2, int str2_is_command, node **symbol, int str1_legal_label){
+static void pre_process_line_error_check(assembler_context *context, char *str1, char *str2, int str2_is_command, node **symbol, int str1_legal_label){
     if (*symbol)
-        print_error_string(line_count, 2, str1);
+        print_error_string(context->first_pass.line_count, 2, str1);
     else if (str1_legal_label && !strcmp("", str2))
-        print_error_string(line_count, 31, str1);
+        print_error_string(context->first_pass.line_count, 31, str1);
     else if (!str2_is_command && str1_legal_label)
-        print_error_string(line_count, 3, str2);
+        print_error_string(context->first_pass.line_count, 3, str2);
 }
 
 /*
@@ -303,24 +492,24 @@ static void pre_process_line_error_check(char *str1, char *str2, int str2_is_com
  * stores the node of the command from the symbols table. "is_legal_label" is called
  * to check if the label is legal and has a colon as its end as well.
  */
-static int pre_process_line(char *label, char *command, int *label_flag, node **symbol){
+static int pre_process_line(assembler_context *context, char *label, char *command, int *label_flag, node **symbol){
     int str1_legal_label, str2_is_command;
     char str1[MAX_BUFFER_SIZE] = "", str2[MAX_BUFFER_SIZE] = "";
-    read_next_string(str1);
-    if (is_command(str1, symbol)){
+    read_next_string(context, str1);
+    if (is_command(context, str1, symbol)){
         strcpy(command, str1);
         return 1;
     }
-    else if ((str1_legal_label = is_legal_label(str1, 1)) && !(*symbol = find_symbol(remove_colon(str1)))){
-        read_next_string(str2);
-        if ((str2_is_command = is_command(str2, symbol))){
+    else if ((str1_legal_label = is_legal_label(context, str1, 1)) && !(*symbol = find_symbol(context, remove_colon(str1)))){
+        read_next_string(context, str2);
+        if ((str2_is_command = is_command(context, str2, symbol))){
             strcpy(label, str1);
             strcpy(command, str2);
             *label_flag = 1;
             return 1;
       }
     }
-    pre_process_line_error_check(str1, str2, str2_is_command, symbol, str1_legal_label);
+    pre_process_line_error_check(context, str1, str2, str2_is_command, symbol, str1_legal_label);
     return 0;
 }
 
@@ -332,23 +521,23 @@ static int pre_process_line(char *label, char *command, int *label_flag, node **
  * indicates if any numbers were read by "read_numbers_list" and "c" is
  * the last character it has went through.
  */
-static void read_numbers_list_error_check(char c, int numbers_read){
+static void read_numbers_list_error_check(assembler_context *context, char c, int numbers_read){
     if (!numbers_read && (c == '\n' || c == ','))
-        print_error(line_count, 25);
+        print_error(context->first_pass.line_count, 25);
     else if (c == '\n')
-        print_error(line_count, 16);
+        print_error(context->first_pass.line_count, 16);
     else if (isdigit(c))
-        print_error(line_count, 14);
+        print_error(context->first_pass.line_count, 14);
     else if ((c == '+' || c == '-')){
-        getc(intput_as);
-        if (isdigit(peek_next_char()))
-            print_error(line_count, 14);
+        read_char(context);
+        if (isdigit(peek_next_char(context)))
+            print_error(context->first_pass.line_count, 14);
         else
-            print_error_char(line_count, 15, c);
-        ungetc(c, intput_as);
+            print_error_char(context->first_pass.line_count, 15, c);
+        unread_char(context, c);
     }
     else if (!isdigit(c))
-        print_error_char(line_count, 15, c);
+        print_error_char(context->first_pass.line_count, 15, c);
 }
 
 /*
@@ -365,25 +554,25 @@ static void read_numbers_list_error_check(char c, int numbers_read){
  * checking function.
  * 
  */
-static int read_numbers_list(void){
+static int read_numbers_list(assembler_context *context){
     int c, number, numbers_read = 0;
     word temp_word;
-    while (read_next_number(&number)){
+    while (read_next_number(context, &number)){
         numbers_read++;
-        if (number > 511 || number < -512) print_warning_int(line_count, 3, number);
+        if (number > 511 || number < -512) print_warning_int(context->first_pass.line_count, 3, number);
         temp_word.value = number;
-        data_array_insert(temp_word);
-        if ((c = peek_next_char()) == '\n' || c == EOF){
-            c = getc(intput_as);
+        data_array_insert(context, temp_word);
+        if ((c = peek_next_char(context)) == '\n' || c == EOF){
+            c = read_char(context);
             return numbers_read;
         }
         else if (c == ','){
-            c = getc(intput_as);
-            skip_whites();
+            c = read_char(context);
+            skip_whites(context);
         }
         else break;
     }
-    read_numbers_list_error_check(peek_next_char(), numbers_read);
+    read_numbers_list_error_check(context, peek_next_char(context), numbers_read);
     return 0;
 }
 
@@ -393,17 +582,17 @@ static int read_numbers_list(void){
  * read by the caller. the parameters are flags indicating if a certain character
  * is detected at a given position in the line.
  */
-static void read_string_error_check(char c, int openning_quotes_flag, int closing_quotes_flag, int excessive_text_flag){
+static void read_string_error_check(assembler_context *context, char c, int openning_quotes_flag, int closing_quotes_flag, int excessive_text_flag){
     if (!openning_quotes_flag && (c == '\n' || c == EOF)){
-        ungetc(c, intput_as);
-        print_error(line_count, 32); 
+        unread_char(context, c);
+        print_error(context->first_pass.line_count, 32); 
     }
     else if (!openning_quotes_flag)
-        print_error(line_count, 17);
+        print_error(context->first_pass.line_count, 17);
     else if (!closing_quotes_flag)
-        print_error(line_count, 18);
+        print_error(context->first_pass.line_count, 18);
     else if (excessive_text_flag)
-        print_error(line_count, 19);
+        print_error(context->first_pass.line_count, 19);
 }
 
 /*
@@ -418,26 +607,26 @@ static void read_string_error_check(char c, int openning_quotes_flag, int closin
  * from the data array, since no output will be produced anyway. if any errors are
  * detected" 0 is returned and error checking function is called.
  */
-static int read_string(void){
+static int read_string(assembler_context *context){
     int c, excessive_text_flag = 0, openning_quotes_flag = 0, closing_quotes_flag = 0;
     word temp_word;
-    if ((c = getc(intput_as)) == '\"'){
+    if ((c = read_char(context)) == '\"'){
         openning_quotes_flag = 1;
-        while((c = getc(intput_as)) != EOF && c != '\n' && c != '\"'){
+        while((c = read_char(context)) != EOF && c != '\n' && c != '\"'){
             temp_word.value = c;
-            data_array_insert(temp_word);
+            data_array_insert(context, temp_word);
         }
-        if (c == '\n' || c == EOF) ungetc(c, intput_as);
+        if (c == '\n' || c == EOF) unread_char(context, c);
         if (c == '\"') closing_quotes_flag = 1;
-        if (c == '\"' && (((c = peek_next_char()) == '\n') || c == EOF)){
+        if (c == '\"' && (((c = peek_next_char(context)) == '\n') || c == EOF)){
             temp_word.value = 0;
-            data_array_insert(temp_word);
-            skip_line();
+            data_array_insert(context, temp_word);
+            skip_line(context);
             return 1;
         }
         else excessive_text_flag = 1;
     }
-    read_string_error_check(c, openning_quotes_flag, closing_quotes_flag, excessive_text_flag);
+    read_string_error_check(context, c, openning_quotes_flag, closing_quotes_flag, excessive_text_flag);
     return 0;
 }
 
@@ -449,15 +638,15 @@ static int read_string(void){
  * followed by comma, otherwise, it is an error. the error checking function for
  * the string part belongs to the string reading function.
  */
-static void struct_error_check(int number_read_flag, int trailing_comma_flag){    
-    if (!number_read_flag && peek_next_char() == '\n')
-        print_error(line_count, 21);
+static void struct_error_check(assembler_context *context, int number_read_flag, int trailing_comma_flag){    
+    if (!number_read_flag && peek_next_char(context) == '\n')
+        print_error(context->first_pass.line_count, 21);
     else if (!number_read_flag && !trailing_comma_flag)
-        print_error(line_count, 22);
-    else if (!number_read_flag && peek_next_char() != ',')
-        print_error_char(line_count, 20, peek_next_char());
+        print_error(context->first_pass.line_count, 22);
+    else if (!number_read_flag && peek_next_char(context) != ',')
+        print_error_char(context->first_pass.line_count, 20, peek_next_char(context));
     else if (number_read_flag && !trailing_comma_flag)
-        print_error(line_count, 23);
+        print_error(context->first_pass.line_count, 23);
 }
 
 /*
@@ -469,19 +658,19 @@ static void struct_error_check(int number_read_flag, int trailing_comma_flag){
  * is responsible for reporting any errors that might occur in the string part
  * and is the one that skips the line in case everything goes well.
  */
-static int process_directive_struct(void){
+static int process_directive_struct(assembler_context *context){
     int status, number, number_read_flag = 0, trailing_comma_flag = 0;
-    if ((status = number_read_flag = read_next_number(&number))){
+    if ((status = number_read_flag = read_next_number(context, &number))){
         word temp_word;
         temp_word.value = number;
-        data_array_insert(temp_word);
-        if ((status = trailing_comma_flag = (peek_next_char() == ','))){
-            getc(intput_as);
-            skip_whites();
-            status = read_string();
+        data_array_insert(context, temp_word);
+        if ((status = trailing_comma_flag = (peek_next_char(context) == ','))){
+            read_char(context);
+            skip_whites(context);
+            status = read_string(context);
         }
     }
-    struct_error_check(number_read_flag, trailing_comma_flag);
+    struct_error_check(context, number_read_flag, trailing_comma_flag);
     return status;
 }
 
@@ -503,26 +692,26 @@ static int process_directive_struct(void){
  * for the second pass processor.
  * the function also makes sure that no trailing text appears after the labels name.
  */
-static int process_directive_ext_ent(int is_ext, int is_label){
+static int process_directive_ext_ent(assembler_context *context, int is_ext, int is_label){
     int status = 1;
     char label[MAX_BUFFER_SIZE];
-    if (is_label) print_warning(line_count, 2);
-    status = status && read_next_string(label);
-    if (status && (status = is_legal_label(label, 0))){
-        if (is_ext && !(find_symbol(label) || entries_list_find(label)))
-            symbol_table_insert_label(label, get_dc(), EXTERN, 0);
-        else if (!is_ext && !entries_list_find(label) && (!find_symbol(label) || find_symbol(label)->type != EXTERN))
-            ent_ext_list_insert(label, 1, line_count);
+    if (is_label) print_warning(context->first_pass.line_count, 2);
+    status = status && read_next_string(context, label);
+    if (status && (status = is_legal_label(context, label, 0))){
+        if (is_ext && !(find_symbol(context, label) || entries_list_find(context, label)))
+            symbol_table_insert_label(context, label, get_dc(context), EXTERN, 0);
+        else if (!is_ext && !entries_list_find(context, label) && (!find_symbol(context, label) || find_symbol(context, label)->type != EXTERN))
+            ent_ext_list_insert(context, label, 1, context->first_pass.line_count);
         else {
             status = 0;
-            print_error_string(line_count, 24, label);             
+            print_error_string(context->first_pass.line_count, 24, label);             
         }
     }
     if (!status) return status;
-    if ((peek_next_char() == '\n' || peek_next_char() == EOF)) skip_line();
+    if ((peek_next_char(context) == '\n' || peek_next_char(context) == EOF)) skip_line(context);
     else {
         status = 0;
-        print_error(line_count, 6);
+        print_error(context->first_pass.line_count, 6);
     }
     return status;
 }
@@ -542,125 +731,133 @@ static int process_directive_ext_ent(int is_ext, int is_label){
  * of the first word that belongs to the directive's section in the data table. the
  * function then calls the proper syntax processing function defined above.
  */
-static int process_directive(node *direct, int is_label, char *label){
+static int process_directive(assembler_context *context, node *direct, int is_label, char *label){
     int status = 1;
     int is_struct = strcmp(direct->key, ".struct") == 0 ? 1 : 0;
     if (!strcmp(direct->key, ".entry"))
-        status = process_directive_ext_ent(0, is_label);
+        status = process_directive_ext_ent(context, 0, is_label);
     else if (!strcmp(direct->key, ".extern"))
-        status = process_directive_ext_ent(1, is_label);
+        status = process_directive_ext_ent(context, 1, is_label);
     else {
         if (is_label)
-            symbol_table_insert_label(label, get_dc(), DATA, is_struct);
+            symbol_table_insert_label(context, label, get_dc(context), DATA, is_struct);
         if (status && !strcmp(direct->key, ".data"))
-            status = read_numbers_list();
+            status = read_numbers_list(context);
         else if (status && !strcmp(direct->key, ".string"))
-            status = read_string();
+            status = read_string(context);
         else if (status && !strcmp(direct->key, ".struct"))
-            status = process_directive_struct();
+            status = process_directive_struct(context);
     }
-    if (!status) skip_line();
+    if (!status) skip_line(context);
     return status;
 }
 
 /*
  * detect_operand_type:
- * detects the operands label and saves it in "dest" and returns it's type as
- * it appears in the input, in order to determine its addressing type. the
- * function reads characters and copies them one by one to "dest" until it is
- * stopped by certain characters. and places '\0' at the end of "dest". it then
- * checks for different indicators to determine the operands addressing type.
+ * detects the operands label and saves it in the "text" field of "dest", sets
+ * its "type" field to the type as it appears in the input, in order to determine
+ * its addressing type, and returns it. the function reads characters and copies
+ * them one by one to "text" until it is stopped by certain characters. and places
+ * '\0' at the end of it. it then checks for different indicators to determine the
+ * operands addressing type. the symbol table node found for a register is kept in
+ * the "symbol" field, so the encoding stage does not need to look it up again.
  * this function will tolerate operands that don't have a space between them and
  * a trailing comma character, for example: "..op1,.." will correctly read "op"
  * and stop at the comma. if you want to be strict about a trailing space, then
  * simply remove the " c != ',' " part from the 4th line of the function, and
  * it will read "op," including the comma from the example above, which will cause
- * an error since this is not a legal operand.
+ * an error since this is not a legal operand. only the first characters of an
+ * operand longer than "text" are saved.
  */
-static int detect_operand_type(char *dest){
+static int detect_operand_type(assembler_context *context, operand *dest){
     int c, length;
-    char *p = dest;
-    while((c = getc(intput_as)) != EOF && c != '\n' && c != ',' && c != ' ' && c != '\t')
-        *p++  = c;
-    ungetc(c, intput_as);
+    char *text = dest->text, *p = text;
+    while((c = read_char(context)) != EOF && c != '\n' && c != ',' && c != ' ' && c != '\t')
+        if (p < text + MAX_BUFFER_SIZE - 1)
+            *p++  = c;
+    unread_char(context, c);
     *p = '\0';
-    length =strlen(dest);
-    if (dest[0] == '#') return IMMEDIATE;
-    else if (dest[length - 2] == '.' && (dest[length - 1] == '1' || dest[length - 1] == '2')) return STRUCT;
-    else if (find_symbol(dest) && find_symbol(dest)->type == REGS) return REGISTER;
-    else if (length > 0) return ABSOLUTE;    
-    else return -1;
+    length = strlen(text);
+    dest->symbol = NULL;
+    if (text[0] == '#') dest->type = IMMEDIATE;
+    else if (length > 1 && text[length - 2] == '.' && (text[length - 1] == '1' || text[length - 1] == '2')) dest->type = STRUCT;
+    else if ((dest->symbol = find_symbol(context, text)) && dest->symbol->type == REGS) dest->type = REGISTER;
+    else if (length > 0) dest->type = ABSOLUTE;
+    else dest->type = -1;
+    return dest->type;
 }
 
 /*
  * detect_operands_error_check:
- * checks if the operands types "op1_type" and "op2_type" were detected successfully,
+ * checks if the operands types of "op1" and "op2" were detected successfully,
  * otherwise the line contained no operands (the default case for an operand is ABSOLUTE
  * ). also checks if a comma is present in case to operands were passed and that
  * there's no additional text at the end of the line. the third case also covers errors
  * that has to do with the user entering too many operands for a given command.
  */
-static void detect_operands_error_check(int *op1_type, int *op2_type, char c, int comma_detected){
-    if (*op1_type == -1 || *op2_type == -1)
-        print_error(line_count, 7);
+static void detect_operands_error_check(assembler_context *context, operand *op1, operand *op2, char c, int comma_detected){
+    if (op1->type == -1 || op2->type == -1)
+        print_error(context->first_pass.line_count, 7);
     else if (!comma_detected)
-        print_error(line_count, 5);
+        print_error(context->first_pass.line_count, 5);
     else if (c != '\n' && c != EOF)
-        print_error(line_count, 6);
+        print_error(context->first_pass.line_count, 6);
 }
 
 /*
  * detect_operands_and_types:
- * reads the operands of an instruction and sets their types by calling
- * "detect_operand_type": stores the results in the pointers passed to it,
- * also receives "data" which is the data field of the symbols node in the 
- * symbol table casted to "instruction" pointer, in order to determine the
- * number of parameters it receives. if any errors are detected, 0 is returned
+ * this is the parsing stage of an instruction line: reads the operands of
+ * an instruction and sets their types by calling "detect_operand_type": stores
+ * the results in the operand records passed to it,
+ * also receives "data" which is the instruction's description in the "isa"
+ * module, in order to determine the number of parameters it receives. if any errors are detected, 0 is returned
  * and the error reporting function is called.
  */
-static int detect_operands_and_types(instruction *data, int *op1_type, int *op2_type, char *op1, char *op2){
+static int detect_operands_and_types(assembler_context *context, const isa_instruction *data, operand *op1, operand *op2){
     int c, status = 1, comma_detected = 1;
-    *op1_type = 0 ; *op2_type = 0;
-    if (data->input) *op1_type = detect_operand_type(op1);
-    if (data->input && data->output){
-        skip_whites();        
-        if (peek_next_char() == ',' ){
-            c = getc(intput_as);
-            skip_whites();
+    op1->type = 0 ; op2->type = 0;
+    if (data->input_modes) detect_operand_type(context, op1);
+    if (data->input_modes && data->output_modes){
+        skip_whites(context);        
+        if (peek_next_char(context) == ',' ){
+            c = read_char(context);
+            skip_whites(context);
         }
         else
             status = comma_detected = 0;
     }
-    if (data->output) *op2_type = detect_operand_type(op2); 
-    if (status && ((c = peek_next_char()) == '\n' || c == EOF) && *op1_type != -1 && *op2_type != -1) skip_line();
+    if (data->output_modes) detect_operand_type(context, op2);
+    if (status && ((c = peek_next_char(context)) == '\n' || c == EOF) && op1->type != -1 && op2->type != -1) skip_line(context);
     else status = 0;
-    if (!status) detect_operands_error_check(op1_type, op2_type, c, comma_detected);
+    if (!status) detect_operands_error_check(context, op1, op2, c, comma_detected);
     return status;
 }
 
 /*
  * check_operands_types:
- * checks if the operands types ("op1_type" and "op2_type") passed to the instruction
+ * the validation stage of an instruction line: checks if the operands types
+ * ("op1_type" and "op2_type") passed to the instruction
  * suit the types it supports for input and output operands, this information is
- * encoded in "data" an "instruction" type defined in the symbols table file header.
+ * encoded as bitmasks of the allowed types in "data", the instruction's description
+ * in the "isa" module.
  * in case this function detects an error it should return the linebreak character 
  * to the input, since it must have been called after "detect_operands_and_types"
  * which have found no error and skipped a line, this will make sure that the next line
  * wont be skipped as well.
  */
-static int check_operands_types(instruction *data, int op1_type, int op2_type){
+static int check_operands_types(assembler_context *context, const isa_instruction *data, int op1_type, int op2_type){
     int status = 1;
-    if (data->input == 1 && (op1_type == IMMEDIATE || op1_type == REGISTER)){
+    if (data->input_modes && !IS_MODE_ALLOWED(data->input_modes, op1_type)){
         status = 0;
-        print_error(line_count, 8);
+        print_error(context->first_pass.line_count, 8);
     }
 
-    if (data->output == 1 && op2_type == IMMEDIATE){
+    if (data->output_modes && !IS_MODE_ALLOWED(data->output_modes, op2_type)){
         status = 0;
-        print_error(line_count, 9);        
+        print_error(context->first_pass.line_count, 9);        
     }
     if (!status)
-        ungetc('\n', intput_as);        
+        unread_char(context, '\n');        
     return status;
 }
 
@@ -668,28 +865,22 @@ static int check_operands_types(instruction *data, int op1_type, int op2_type){
  * create_instruction_word:
  * creates the word that should be stored in the instructions array of the data
  * memory, depending on the operands addressing types, the instruction's code
- * (represented by 4 bits) and the result is stored in "target" word.
+ * (represented by 4 bits) and the result is stored in "target" word. the type
+ * of a missing operand is 0, so it adds nothing to the word.
  */
-static void create_instruction_word(instruction *data, word *target, int op1_type, int op2_type){
-    if (data->input)
-        target->value +=  op1_type<< 4;
-    if (data->output)
-        target->value +=  op2_type<< 2;	
+static void create_instruction_word(const isa_instruction *data, word *target, int op1_type, int op2_type){
+    target->value = ENCODE_INSTRUCTION(data->opcode, op1_type, op2_type);
 }
 
 /*
  * extract_regs_value:
- * "symbol" is the name of the register ("rX"), and "is_input" indicates
- * if the register is passed as input or output operand. the function extracts
- * the word which represents the registers encoding as an operand from the 
- * data field of the registers symbol in the symbols table cast to "regs"
- * pointer type.
- */
-static int extract_regs_value(char *symbol, int is_input){
-    if (is_input)
-        return ((regs*)(find_symbol(symbol)->data))->input_op.value;
-    else
-        return ((regs*)(find_symbol(symbol)->data))->output_op.value;
+ * "symbol" is the register's node in the symbols table, and "is_input" indicates
+ * if the register is passed as input or output operand. the function returns
+ * the registers encoding as an operand, computed from the register's code
+ * stored in the node's index field.
+ */
+static int extract_regs_value(node *symbol, int is_input){
+    return ENCODE_REGISTER(symbol->index, is_input);
 }
 
 /*
@@ -725,16 +916,16 @@ static int is_number(char *number){
  * in the array: 00-000001-00 for 1 and 00-000010-00 for 2. if the label (the part
  * up to the '.') is legal, status is 1, 0 otherwise.
  */
-static int process_struct(char *op){
+static int process_struct(assembler_context *context, char *op){
     int status = 1, length = strlen(op);
     int index_part = op[length - 1] - '0';
     op[length - 2] = '\0';
-    if ((status = is_legal_label(op, 0))){
+    if ((status = is_legal_label(context, op, 0))){
         word temp_word = {0};
-        spl_insert(op, get_ic(), line_count, 1);
-        instructions_array_insert(temp_word);
+        spl_insert(context, op, get_ic(context), context->first_pass.line_count, 1);
+        instructions_array_insert(context, temp_word);
         temp_word.value = index_part<<2;
-        instructions_array_insert(temp_word);        
+        instructions_array_insert(context, temp_word);        
     }
     return status;
 }
@@ -747,24 +938,24 @@ static int process_struct(char *op){
  * still is not an error. if the "op" is indeed a number then status is 1, otherwise
  * 0 is returned by the function and an error is printed.
  */
-static int process_immediate(char *op, word *temp_word){
+static int process_immediate(assembler_context *context, char *op, word *temp_word){
     int status;
     union {int value :8;} item;
     int value = atoi(++op);
     item.value = value;
     temp_word->value = (item.value)<<2;
-    instructions_array_insert(*temp_word);
+    instructions_array_insert(context, *temp_word);
     if (value > 127 || value < -128)
-        print_warning_int(line_count, 1, value);
+        print_warning_int(context->first_pass.line_count, 1, value);
     status = is_number(op);
-    if(!status) print_error_string(line_count, 10, op);
+    if(!status) print_error_string(context->first_pass.line_count, 10, op);
     return status;
 }
 
 /*
  * process_operand:
  * this function decides which action to take in order to store the operand "op"
- * in the instructions array based on its addressing "type": if it's either a number
+ * in the instructions array based on its addressing type: if it's either a number
  * ("IMMEDIATE") or a "STRUCT", the proper function is called, if it's "REGISTER" 
  * then it's encoding is stored (depending on "is_input" flag's value). if it's
  * of "ABSOLUTE" type: then 0 is inserted in the instructions array (the address
@@ -775,43 +966,43 @@ static int process_immediate(char *op, word *temp_word){
  * set to 1 if the "op" is a legal operand name, error reporting is done by the 
  * "is_legal_label" function.
  */
-static int process_operand(int type, char *op, int is_input){
-    int status = 1;
+static int process_operand(assembler_context *context, operand *op, int is_input){
+    int status = 1, type = op->type;
     word temp_word = {0};
     if (type == REGISTER){
-        temp_word.value = extract_regs_value(op, is_input);
-        instructions_array_insert(temp_word);
+        temp_word.value = extract_regs_value(op->symbol, is_input);
+        instructions_array_insert(context, temp_word);
     }
-    else if (type == IMMEDIATE) status = process_immediate(op, &temp_word);
-    else if (type == ABSOLUTE && (status = is_legal_label(op, 0))) {
-        spl_insert(op, get_ic(), line_count, 0);
-        ent_ext_list_insert(op, 0, get_ic());
-        instructions_array_insert(temp_word);
+    else if (type == IMMEDIATE) status = process_immediate(context, op->text, &temp_word);
+    else if (type == ABSOLUTE && (status = is_legal_label(context, op->text, 0))) {
+        spl_insert(context, op->text, get_ic(context), context->first_pass.line_count, 0);
+        ent_ext_list_insert(context, op->text, 0, get_ic(context));
+        instructions_array_insert(context, temp_word);
     }
-    else if (type == STRUCT) status = process_struct(op);
+    else if (type == STRUCT) status = process_struct(context, op->text);
     return status;
 }
 
 /*
  * store_operands:
- * responsible for storing the operands ("op1" and "op2") based on types ("op1_type"
- * and "op2_type") by calling "process_operand" for each of up to two operands (input
- * and output). the only special case that this function takes care of itself is
+ * the encoding stage of an instruction line: responsible for storing the operands
+ * ("op1" and "op2") based on their types by calling "process_operand" for each of
+ * up to two operands (input and output). the only special case that this function takes care of itself is
  * when both operands are registers and the words should be combined to one word,
  * in this case, their values are extracted, summed and stored. the integer value
  * returned indicates success (if the called function return success as well), otherwise
  * 0 is returned.
  */
-static int store_operands(instruction *data, int op1_type, int op2_type, char *op1, char *op2){
+static int store_operands(assembler_context *context, const isa_instruction *data, operand *op1, operand *op2){
     int status = 1;
-    if (op1_type == REGISTER && op2_type == REGISTER){
+    if (op1->type == REGISTER && op2->type == REGISTER){
         word temp_word = {0};
-        temp_word.value += extract_regs_value(op1, 1) + extract_regs_value(op2, 0);
-        instructions_array_insert(temp_word);
+        temp_word.value += extract_regs_value(op1->symbol, 1) + extract_regs_value(op2->symbol, 0);
+        instructions_array_insert(context, temp_word);
     }
     else {
-        if (data->input) status = status && process_operand(op1_type, op1, 1);
-        if (status && data->output) status = status && process_operand(op2_type, op2, 0);
+        if (data->input_modes) status = status && process_operand(context, op1, 1);
+        if (status && data->output_modes) status = status && process_operand(context, op2, 0);
     }
     return status;
 }
@@ -821,26 +1012,30 @@ static int store_operands(instruction *data, int op1_type, int op2_type, char *o
  * responsible for processing an instruction line by calling the relevant
  * functions: first, if a "label" is present (determined by "is_label" flag),
  * the label is inserted in the symbols table as an instruction label "INST_L".
- * then, "detect_operands_and_types" is called to detect the operands and their
- * types and to perform error checking, if no errors are detected, the instruction
- * word with the operands encoding is created and stored in the instructions array,
- * and "store_operands" is called to store the operands values and addresses, depending
- * on their encoding, otherwise, the line is skipped and 0 is returned to the calling
- * function.
- */
-static int process_instruction(node *inst, int is_label, char *label){
-    int op1_type = -1, op2_type = -1, status = 1;
-    char op1[MAX_BUFFER_SIZE] = "", op2[MAX_BUFFER_SIZE] = "";
-    instruction *data = (instruction*)(inst->data);
-    word output_value = data->value;
-    if (is_label) symbol_table_insert_label(label, get_ic(), INST_L, 0);
-    if ((status = (detect_operands_and_types(data, &op1_type, &op2_type, op1, op2) && check_operands_types(data, op1_type, op2_type))))
-        create_instruction_word(data,&output_value, op1_type, op2_type);
-    if (!status) skip_line();
+ * the rest of the line goes through three stages which hand over two "operand"
+ * records: "detect_operands_and_types" parses the operands, their types and the
+ * register symbols they refer to and performs error checking, "check_operands_types"
+ * validates the types against the instruction, and if no errors are detected, the
+ * instruction word with the operands encoding is created and stored in the
+ * instructions array, and "store_operands" encodes the operands values and addresses
+ * from the records, otherwise, the line is skipped and 0 is returned to the calling
+ * function. if "cache_key" is not NULL, the line is cached once it's processed successfully.
+ */
+static int process_instruction(assembler_context *context, node *inst, int is_label, char *label, char *cache_key){
+    int status = 1, first_index = get_ic(context);
+    operand op1 = {"", -1, NULL}, op2 = {"", -1, NULL};
+    const isa_instruction *data = isa_instruction_at(inst->index);
+    word output_value = {0};
+    if (is_label) symbol_table_insert_label(context, label, get_ic(context), INST_L, 0);
+    if ((status = (detect_operands_and_types(context, data, &op1, &op2) && check_operands_types(context, data, op1.type, op2.type))))
+        create_instruction_word(data,&output_value, op1.type, op2.type);
+    if (!status) skip_line(context);
     else {
-        instructions_array_insert(output_value);
-        if (data->input || data->output)
-            status = status && store_operands(data, op1_type, op2_type, op1, op2);
+        instructions_array_insert(context, output_value);
+        if (data->input_modes || data->output_modes)
+            status = status && store_operands(context, data, &op1, &op2);
+        if (status && cache_key && !is_label)
+            cache_instruction_line(context, cache_key, data, &op1, &op2, first_index);
     }
     return status;
 }
@@ -851,28 +1046,35 @@ static int process_instruction(node *inst, int is_label, char *label){
  * is blank or is a comment, it is skipped, otherwise, "pre_process_line" is
  * called to determine the command type and if a label is present, and if no
  * errors are detected, the proper command processing function is called, either
- * a directive or an instruction. each function called down the line should
+ * a directive or an instruction. before that, the line is looked up in the
+ * encoding cache, and if it's found its words are stored without any further
+ * processing. each function called down the line should
  * return its status of success: if no errors are detected by one of them,
  * the chain of functions called are responsible for skipping the line, if an
  * error is detected, the line processing should stop and this function must do
  * the line skipping part.
  */
-static int process_line(void){
-    char label[MAX_BUFFER_SIZE], command[MAX_BUFFER_SIZE];
-    int label_flag = 0, status =1;
+static int process_line(assembler_context *context){
+    char label[MAX_BUFFER_SIZE], command[MAX_BUFFER_SIZE], cache_key[CACHE_KEY_SIZE];
+    int label_flag = 0, status =1, has_key;
     node *symbol;
-    if (is_comment_or_empty_line() || peek_next_char() == EOF){
-        skip_line();
+    cache_entry *cached;
+    if (is_comment_or_empty_line(context) || peek_next_char(context) == EOF){
+        skip_line(context);
         return status;        
     }
-    if ((status = pre_process_line(label, command, &label_flag, &symbol))){
+    if ((has_key = read_line_key(context, cache_key)) && (cached = encoding_cache_find(cache_key))){
+        store_cached_words(context, cached);
+        return status;
+    }
+    if ((status = pre_process_line(context, label, command, &label_flag, &symbol))){
         if (symbol->type == INST)
-            status = process_instruction(symbol, label_flag, label);
+            status = process_instruction(context, symbol, label_flag, label, has_key ? cache_key : NULL);
         else if (symbol->type == DIRECT)
-            status = process_directive(symbol, label_flag, label);
+            status = process_directive(context, symbol, label_flag, label);
     }
     else
-       skip_line();
+       skip_line(context);
     return status;
 }
 
@@ -883,19 +1085,20 @@ static int process_line(void){
  * files will be produced, since an error was detected and reported. the function
  * does not stop if a line had an error, so each line which has at least one error
  * is reported. "line_count" is incremented with each new line detected and the
- * function stops when EOF is detected in one of the lines.
+ * function stops when EOF is detected in one of the lines, or when the file goes
+ * over its limits (see "resource_limits").
  */
-int first_pass_process(void){
+int first_pass_process(assembler_context *context){
     int status;
     status = 1;
-    if (intput_as){
+    if (context->first_pass.input.text){
         int temp_status;
-        while(!feof(intput_as)){
-            line_count++;
-            if (!(temp_status = process_line()))
+        while(!context->first_pass.input.eof_flag){
+            check_line_limits(++context->first_pass.line_count);
+            if (!(temp_status = process_line(context)))
                 status = 0;
         }
     }
-    printf("\nLines Processed : %d\nFirst pass status: %s\n", line_count, status ? "Success" : "Failure");
+    fprintf(status_output(), "\nLines Processed : %d\nFirst pass status: %s\n", context->first_pass.line_count, status ? "Success" : "Failure");
     return status;
 }
\ No newline at end of file
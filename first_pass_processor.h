@@ -8,14 +8,57 @@
     #include "symbol_table.h"
     #include "memory_manager.h"
     #include "second_pass_processor.h"
+    #include "encoding_cache.h"
     
     /*the max string size allowed for a string, as the maximum line width allowed*/
     #define MAX_BUFFER_SIZE 80
+    /*the initial size of the buffer the input file is read into, doubled as needed*/
+    #define INPUT_CHUNK_SIZE 4096
+    /*the maximum count of characters returned to the input that were not read last*/
+    #define MAX_PUSHED_CHARS 4
 
-    typedef enum addressing_type {IMMEDIATE, ABSOLUTE, STRUCT, REGISTER } addressing_type;
+    /*
+     * the input file's contents: "text" holds "length" characters, "position"
+     * is the index of the next character to be read, "time_check" is the index
+     * at which the time the file takes is checked next (see "next_time_check"),
+     * "pushed" stores characters returned to the input and "eof_flag" is set
+     * once the end has been read.
+     */
+    typedef struct input_buffer {
+        char *text;
+        size_t length;
+        size_t position;
+        size_t time_check;
+        int pushed[MAX_PUSHED_CHARS];
+        int pushed_count;
+        int eof_flag;
+    } input_buffer;
 
-    FILE *load_input_file(char*);
-    void close_input_file(void);
-    int first_pass_process(void);
+    /*
+     * the state of the file being processed by the first pass: "input" holds
+     * the whole input file, which is read into memory once by "load_input_file",
+     * and "line_count" is the number of the line being processed.
+     */
+    typedef struct first_pass_state {
+        input_buffer input;
+        int line_count;
+    } first_pass_state;
+
+    /*
+     * an instruction's operand as it is handed from the parsing stage to the
+     * encoding stage: its "text", its addressing "type" (-1 if missing) and the
+     * symbol table node it was found to refer to, if any.
+     */
+    typedef struct operand {
+        char text[MAX_BUFFER_SIZE];
+        int type;
+        node *symbol;
+    } operand;
+
+    int load_input_file(assembler_context*, char*);
+    void load_input_text(assembler_context*, const char*, size_t);
+    int get_line_count(assembler_context*);
+    void close_input_file(assembler_context*);
+    int first_pass_process(assembler_context*);
    
 #endif
\ No newline at end of file
@@ -53,10 +53,12 @@ hash_table *hash_table_construct(int size, int (*function)(char*, int)){
 /*
  * hash_table_free:
  * frees the memory allocated to "table" and all of its members and their
- * members.
+ * members. nothing is done if "table" is NULL.
  */
 void hash_table_free(hash_table *table){
     int i;
+    if (!table)
+        return;
     for(i = 0; i < table->array_size; i++)
         free_linked_list((table->array)[i]);
     free(table->array);
@@ -85,7 +87,7 @@ int hash_table_insert(hash_table *table, char *key, void *data, int type){
         return 1;
     }
     else{
-        fprintf(stderr, "Error: item is already present: %s\n", key);
+        fprintf(error_output(), "Error: item is already present: %s\n", key);
         return 0;   
     }
 }
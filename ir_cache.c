@@ -0,0 +1,278 @@
+#define _POSIX_C_SOURCE 200809L
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ir_cache.h"
+#include "prelude.h"
+
+/*
+ * This module keeps the state the first pass leaves (the "parse IR") in a file
+ * next to the source, so a source which did not change since it was assembled
+ * last does not go through the first pass again, for instance when only the
+ * output format changed: the IR is restored instead and the second pass and the
+ * output files go on from it. the IR holds the memory's words, the fixups, the
+ * file's labels, the entries and externs lists and the messages the first pass
+ * printed, which are printed again when it's restored. it's a compact binary
+ * file, in the layout of the structs in the header (it's only meant to be read
+ * by the same program on the same machine), which is mapped to memory to be
+ * read, and used only if the hash of the source and the options the first pass
+ * depends on match the one it was made with. "Examples/Hex" holds the files of
+ * the examples' correct inputs in the "hex" format, which are the same whether
+ * they are assembled or restored from the IR files of an earlier assembly in
+ * the default format.
+ */
+
+/*"ir_enabled": whether the first pass's state is kept in IR files*/
+static int ir_enabled = 0;
+
+/*
+ * set_ir_cache:
+ * keeps the first pass's state in IR files if "enabled" is not 0.
+ */
+void set_ir_cache(int enabled){
+    ir_enabled = enabled;
+}
+
+/*
+ * ir_cache_enabled:
+ * returns 1 if the first pass's state is kept in IR files, 0 otherwise.
+ */
+int ir_cache_enabled(void){
+    return ir_enabled;
+}
+
+/*
+ * ir_key:
+ * stores in "key" (OUTPUT_KEY_SIZE characters) the key of the source loaded to
+ * "context": the hash of the source and a line naming the version,
+ * the sizes and the prelude the first pass depends on.
+ */
+static void ir_key(assembler_context *context, char *key){
+    input_buffer *input = &context->first_pass.input;
+    char options[128];
+    sprintf(options, "%s %d %d %lu %s\n", IR_VERSION, C, MEMORY_SIZE, (unsigned long)input->length, get_prelude_key());
+    hash_source_key(options, input->text, input->length, key);
+}
+
+/*
+ * ir_size:
+ * returns the number of characters of the IR file which starts with "header".
+ */
+static size_t ir_size(const ir_header *header){
+    return sizeof(ir_header) + (header->IC + header->DC) * sizeof(word) + header->fixups_count * sizeof(fixup)
+            + header->labels_count * sizeof(ir_label) + (header->entries_count + header->externs_count) * sizeof(ir_reference)
+            + header->messages_length + header->errors_length;
+}
+
+/*
+ * valid_header:
+ * checks whether the "length" characters of "text" are an IR file of the source
+ * whose key is "key", with counts which fit the program's limits. returns 1 if
+ * so, 0 otherwise.
+ */
+static int valid_header(const char *text, size_t length, const char *key){
+    const ir_header *header = (const ir_header*)text;
+    if (length < sizeof(ir_header) || memcmp(header->magic, IR_MAGIC, IR_MAGIC_SIZE) || strcmp(header->key, key))
+        return 0;
+    if (header->IC < 0 || header->DC < 0 || header->IC + header->DC > MEMORY_SIZE || header->fixups_count < 0
+            || header->labels_count < 0 || header->entries_count < 0 || header->externs_count < 0
+            || header->messages_length < 0 || header->errors_length < 0)
+        return 0;
+    return ir_size(header) == length;
+}
+
+/*
+ * restore_references:
+ * inserts the "count" list nodes at "items" to the entries list if "is_ent" is
+ * not 0, or to the externs list, in the order they were saved in. returns the
+ * end of the items.
+ */
+static const char *restore_references(assembler_context *context, const char *items, int count, int is_ent){
+    const ir_reference *references = (const ir_reference*)items;
+    int i;
+    for (i = count - 1; i >= 0; i--)
+        ent_ext_list_insert(context, (char*)references[i].key, is_ent, references[i].index);
+    return items + count * sizeof(ir_reference);
+}
+
+/*
+ * restore_ir:
+ * restores the first pass's state saved in the IR file "text", which should be
+ * valid, to "context", prints the messages saved with it and returns
+ * the first pass's status.
+ */
+static int restore_ir(assembler_context *context, const char *text){
+    const ir_header *header = (const ir_header*)text;
+    const ir_label *labels;
+    const char *p = text + sizeof(ir_header);
+    int i;
+    memcpy(context->memory.instructions_array, p, header->IC * sizeof(word));
+    p += header->IC * sizeof(word);
+    memcpy(context->memory.data_array, p, header->DC * sizeof(word));
+    p += header->DC * sizeof(word);
+    context->memory.IC = header->IC;
+    context->memory.DC = header->DC;
+    context->memory.memory_full_flag = header->memory_full_flag;
+    context->first_pass.line_count = header->line_count;
+    check_line_limits(header->line_count);
+    check_time_limit();
+    if (header->fixups_count > context->second_pass.fixups_capacity){
+        fixup *temp;
+        count_allocation((header->fixups_count - context->second_pass.fixups_capacity) * sizeof(fixup));
+        temp = (fixup*)realloc(context->second_pass.fixups, header->fixups_count * sizeof(fixup));
+        if (!temp)
+            exit_program_fatal_error();
+        context->second_pass.fixups = temp;
+        context->second_pass.fixups_capacity = header->fixups_count;
+    }
+    memcpy(context->second_pass.fixups, p, header->fixups_count * sizeof(fixup));
+    context->second_pass.fixups_count = header->fixups_count;
+    p += header->fixups_count * sizeof(fixup);
+    labels = (const ir_label*)p;
+    for (i = 0; i < header->labels_count; i++)
+        symbol_table_insert_label(context, (char*)labels[i].key, labels[i].address, labels[i].type, labels[i].is_struct);
+    p += header->labels_count * sizeof(ir_label);
+    p = restore_references(context, p, header->entries_count, 1);
+    p = restore_references(context, p, header->externs_count, 0);
+    fwrite(p, 1, header->messages_length, status_output());
+    fwrite(p + header->messages_length, 1, header->errors_length, error_output());
+    return header->status;
+}
+
+/*
+ * load_ir:
+ * maps the IR file named "path" to memory, and if it was made of the source
+ * whose key is "key", restores it and stores the first pass's status in
+ * "status". returns 1 if it was restored, 0 otherwise.
+ */
+static int load_ir(assembler_context *context, const char *path, const char *key, int *status){
+    struct stat info;
+    char *text;
+    int fd = open(path, O_RDONLY), loaded = 0;
+    if (fd < 0)
+        return 0;
+    if (!fstat(fd, &info) && info.st_size >= (off_t)sizeof(ir_header)
+            && (text = (char*)mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) != MAP_FAILED){
+        if ((loaded = valid_header(text, info.st_size, key)))
+            *status = restore_ir(context, text);
+        munmap(text, info.st_size);
+    }
+    close(fd);
+    return loaded;
+}
+
+/*
+ * save_references:
+ * appends the nodes of "list" to "file", from the first to the last, and
+ * returns their number.
+ */
+static int save_references(output_buffer *file, linked_list *list){
+    ir_reference item;
+    node *curr;
+    int count = 0;
+    for (curr = list->head; curr; curr = curr->next, count++){
+        memset(&item, 0, sizeof(ir_reference));
+        strcpy(item.key, curr->key);
+        item.index = curr->index;
+        output_buffer_append(file, (char*)&item, sizeof(ir_reference));
+    }
+    return count;
+}
+
+/*
+ * save_labels:
+ * appends the labels of the symbol table in "context" to "file", and
+ * returns their number.
+ */
+static int save_labels(assembler_context *context, output_buffer *file){
+    hash_table *table = context->symbol_table;
+    ir_label item;
+    node *curr;
+    int i, count = 0;
+    for (i = 0; i < table->array_size; i++)
+        for (curr = table->array[i]->head; curr; curr = curr->next, count++){
+            memset(&item, 0, sizeof(ir_label));
+            strcpy(item.key, curr->key);
+            item.type = curr->type;
+            item.address = ((label*)curr->data)->address.value;
+            item.is_struct = ((label*)curr->data)->is_struct;
+            output_buffer_append(file, (char*)&item, sizeof(ir_label));
+        }
+    return count;
+}
+
+/*
+ * save_ir:
+ * writes the first pass's state, left in "context" with the status
+ * "status", to the IR file named "path", with the key "key" and the "messages"
+ * and "errors" it printed.
+ */
+static void save_ir(assembler_context *context, char *path, const char *key, int status, output_buffer *messages, output_buffer *errors){
+    output_buffer file;
+    ir_header header;
+    memset(&header, 0, sizeof(ir_header));
+    memcpy(header.magic, IR_MAGIC, IR_MAGIC_SIZE);
+    strcpy(header.key, key);
+    header.status = status;
+    header.memory_full_flag = context->memory.memory_full_flag;
+    header.IC = context->memory.IC;
+    header.DC = context->memory.DC;
+    header.line_count = context->first_pass.line_count;
+    header.fixups_count = context->second_pass.fixups_count;
+    header.messages_length = messages->length;
+    header.errors_length = errors->length;
+    output_buffer_init(&file, 0);
+    output_buffer_append(&file, (char*)&header, sizeof(ir_header));
+    output_buffer_append(&file, (char*)context->memory.instructions_array, header.IC * sizeof(word));
+    output_buffer_append(&file, (char*)context->memory.data_array, header.DC * sizeof(word));
+    output_buffer_append(&file, (char*)context->second_pass.fixups, header.fixups_count * sizeof(fixup));
+    header.labels_count = save_labels(context, &file);
+    header.entries_count = save_references(&file, context->second_pass.entries_list);
+    header.externs_count = save_references(&file, context->second_pass.externs_list);
+    output_buffer_append(&file, messages->text, messages->length);
+    output_buffer_append(&file, errors->text, errors->length);
+    memcpy(file.text, &header, sizeof(ir_header));
+    output_buffer_write_file(&file, path);
+    output_buffer_free(&file);
+}
+
+/*
+ * captured_buffer:
+ * sets "buffer" to the "length" characters of "text", captured by a memory
+ * stream, so it can be written as any other buffer. the text is still freed
+ * with its capture.
+ */
+static void captured_buffer(output_buffer *buffer, char *text, size_t length){
+    buffer->text = text;
+    buffer->length = length;
+    buffer->capacity = length + 1;
+}
+
+/*
+ * ir_first_pass:
+ * stands for "first_pass_process" on the source loaded to "context":
+ * if the IR file named "path" was made of the same source, the first pass's
+ * state is restored from it, otherwise the first pass runs, with its messages
+ * captured (and printed once it's done), and its state is saved to the IR file.
+ * returns the first pass's status.
+ */
+int ir_first_pass(assembler_context *context, char *path){
+    char key[OUTPUT_KEY_SIZE];
+    output_capture *capture;
+    output_buffer messages, errors;
+    int status;
+    ir_key(context, key);
+    if (load_ir(context, path, key, &status))
+        return status;
+    begin_capture();
+    status = first_pass_process(context);
+    capture = end_capture();
+    captured_buffer(&messages, capture->out_text, capture->out_length);
+    captured_buffer(&errors, capture->err_text, capture->err_length);
+    fwrite(messages.text, 1, messages.length, status_output());
+    fwrite(errors.text, 1, errors.length, error_output());
+    save_ir(context, path, key, status, &messages, &errors);
+    free_capture(capture);
+    return status;
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#ifndef IR_CACHE_H
+#define IR_CACHE_H
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include "assembler_context.h"
+    #include "output_cache.h"
+
+    /*the extension of the file a source's parse IR is kept in, next to the source*/
+    #define IR_EXTENSION ".ir"
+    /*the characters an IR file starts with, including the terminating '\0'*/
+    #define IR_MAGIC "ASMIR01"
+    #define IR_MAGIC_SIZE 8
+    /*
+     * identifies the layout and the meaning of the IR: it should be changed
+     * whenever a change to the first pass changes the state it leaves, so files
+     * written by an older version are not used.
+     */
+    #define IR_VERSION "ir-1"
+
+    /*
+     * the beginning of an IR file: the "key" of the source it was made of, the
+     * status the first pass returned, the memory's "memory_full_flag", "IC" and
+     * "DC", the number of lines processed ("line_count"), and the number of
+     * items of each of the sections which follow it, in this order: the
+     * instructions words, the data words, the fixups, the labels, the entries
+     * list, the externs list, and the status messages and the errors printed
+     * by the first pass.
+     */
+    typedef struct ir_header {
+        char magic[IR_MAGIC_SIZE];
+        char key[OUTPUT_KEY_SIZE];
+        int status;
+        int memory_full_flag;
+        int IC;
+        int DC;
+        int line_count;
+        int fixups_count;
+        int labels_count;
+        int entries_count;
+        int externs_count;
+        long messages_length;
+        long errors_length;
+    } ir_header;
+
+    /*a label of the symbol table as an IR file holds it: its name, type and "label" fields*/
+    typedef struct ir_label {
+        char key[MAX_NAME_SIZE];
+        int type;
+        int address;
+        int is_struct;
+    } ir_label;
+
+    /*a node of the entries or the externs list as an IR file holds it*/
+    typedef struct ir_reference {
+        char key[MAX_NAME_SIZE];
+        int index;
+    } ir_reference;
+
+    void set_ir_cache(int);
+    int ir_cache_enabled(void);
+    int ir_first_pass(assembler_context*, char*);
+
+#endif
\ No newline at end of file
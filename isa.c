@@ -0,0 +1,64 @@
+#include "isa.h"
+
+/*
+ * This module holds the tables that describe the imaginary processor's
+ * instruction set and registers. the tables are generated at compile time
+ * from the "INSTRUCTION_SET" and "REGISTER_SET" lists in the header, so the
+ * symbol table, the first pass processor's validation and encoding, and any
+ * decoding of words back to instructions all use the same description.
+ * the instructions are listed in opcode order and the registers in code
+ * order, so an opcode or a register code is a direct index to its entry.
+ */
+
+/*the instructions, indexed by their opcode*/
+static const isa_instruction instruction_set[INSTRUCTIONS_COUNT] = {
+#define X(name, opcode, input_modes, output_modes) {#name, opcode, input_modes, output_modes},
+    INSTRUCTION_SET
+#undef X
+};
+
+/*the registers, indexed by their code*/
+static const isa_register register_set[REGISTERS_TOTAL] = {
+#define X(name, code) {#name, code},
+    REGISTER_SET
+#undef X
+};
+
+/*the number of words an operand of each addressing type occupies*/
+static const int operand_words[] = {1, 1, 2, 1};
+
+/*
+ * isa_instruction_at:
+ * returns the description of the instruction whose opcode is "opcode".
+ * only the 4 bits of the opcode are used.
+ */
+const isa_instruction *isa_instruction_at(int opcode){
+    return &instruction_set[opcode & 15];
+}
+
+/*
+ * isa_decode_instruction:
+ * returns the description of the instruction encoded in the instruction
+ * word "value", using its opcode bits.
+ */
+const isa_instruction *isa_decode_instruction(word value){
+    return &instruction_set[DECODE_OPCODE(value.value)];
+}
+
+/*
+ * isa_register_at:
+ * returns the description of the register whose code is "code", or NULL
+ * if there is no such register.
+ */
+const isa_register *isa_register_at(int code){
+    return (code >= 0 && code < REGISTERS_TOTAL) ? &register_set[code] : NULL;
+}
+
+/*
+ * isa_operand_words:
+ * returns the number of words an operand of addressing type "type" occupies
+ * following the instruction word. two register operands share one word.
+ */
+int isa_operand_words(int type){
+    return operand_words[type & 3];
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#ifndef ISA_H
+#define ISA_H
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include "word.h"
+
+    /*
+     * the imaginary processor's instruction set: each line describes one
+     * instruction with its name, its opcode (the 4 leftmost bits of the
+     * instruction word) and the addressing types allowed for its input
+     * (source) and output (destination) operands, as bitmasks of
+     * "addressing_type". an instruction that has no operand has 0 as its
+     * mask. this is the only place the instruction set is defined: the
+     * tables in "isa.c" are generated from it with the "X" macro.
+     */
+    #define INSTRUCTION_SET \
+        X(mov,  0, ALL_MODES,    NON_IMMEDIATE_MODES) \
+        X(cmp,  1, ALL_MODES,    ALL_MODES) \
+        X(add,  2, ALL_MODES,    NON_IMMEDIATE_MODES) \
+        X(sub,  3, ALL_MODES,    NON_IMMEDIATE_MODES) \
+        X(not,  4, NO_MODES,     NON_IMMEDIATE_MODES) \
+        X(clr,  5, NO_MODES,     NON_IMMEDIATE_MODES) \
+        X(lea,  6, MEMORY_MODES, NON_IMMEDIATE_MODES) \
+        X(inc,  7, NO_MODES,     NON_IMMEDIATE_MODES) \
+        X(dec,  8, NO_MODES,     NON_IMMEDIATE_MODES) \
+        X(jmp,  9, NO_MODES,     NON_IMMEDIATE_MODES) \
+        X(bne, 10, NO_MODES,     NON_IMMEDIATE_MODES) \
+        X(red, 11, NO_MODES,     NON_IMMEDIATE_MODES) \
+        X(prn, 12, NO_MODES,     ALL_MODES) \
+        X(jsr, 13, NO_MODES,     NON_IMMEDIATE_MODES) \
+        X(rts, 14, NO_MODES,     NO_MODES) \
+        X(stop,15, NO_MODES,     NO_MODES)
+
+    /*
+     * the processor's registers: their names and codes. r0-r7 occupy codes
+     * 0-7 and "PSW" occupies code 8 ("REGISTERS_COUNT").
+     */
+    #define REGISTER_SET \
+        X(r0, 0) \
+        X(r1, 1) \
+        X(r2, 2) \
+        X(r3, 3) \
+        X(r4, 4) \
+        X(r5, 5) \
+        X(r6, 6) \
+        X(r7, 7) \
+        X(PSW, 8)
+
+    typedef enum addressing_type {IMMEDIATE, ABSOLUTE, STRUCT, REGISTER } addressing_type;
+
+    /*bitmasks of the addressing types allowed for an operand*/
+    #define MODE_BIT(type) (1 << (type))
+    #define NO_MODES 0
+    #define MEMORY_MODES (MODE_BIT(ABSOLUTE) | MODE_BIT(STRUCT))
+    #define NON_IMMEDIATE_MODES (MODE_BIT(ABSOLUTE) | MODE_BIT(STRUCT) | MODE_BIT(REGISTER))
+    #define ALL_MODES (MODE_BIT(IMMEDIATE) | MODE_BIT(ABSOLUTE) | MODE_BIT(STRUCT) | MODE_BIT(REGISTER))
+    #define IS_MODE_ALLOWED(modes, type) (((modes) >> (type)) & 1)
+
+    /*the number of instructions and registers defined above*/
+    #define INSTRUCTIONS_COUNT 16
+    #define REGISTERS_COUNT 8
+    #define REGISTERS_TOTAL (REGISTERS_COUNT + 1)
+
+    /*
+     * the fields of an instruction word: opcode in bits 6-9, input operand
+     * addressing type in bits 4-5, output operand addressing type in bits 2-3.
+     * a register's code is in bits 6-9 as an input operand and in bits 2-5 as
+     * an output operand.
+     */
+    #define ENCODE_INSTRUCTION(opcode, input_type, output_type) (((opcode) << 6) | ((input_type) << 4) | ((output_type) << 2))
+    #define ENCODE_REGISTER(code, is_input) ((is_input) ? (code) << 6 : (code) << 2)
+    #define DECODE_OPCODE(value) (((value) >> 6) & 15)
+    #define DECODE_INPUT_TYPE(value) (((value) >> 4) & 3)
+    #define DECODE_OUTPUT_TYPE(value) (((value) >> 2) & 3)
+    #define DECODE_INPUT_REGISTER(value) (((value) >> 6) & 15)
+    #define DECODE_OUTPUT_REGISTER(value) (((value) >> 2) & 15)
+
+    /*
+     * describes an instruction: its "name", "opcode" and the bitmasks of the
+     * addressing types allowed for its "input_modes" and "output_modes".
+     */
+    typedef struct isa_instruction {
+        const char *name;
+        int opcode;
+        int input_modes;
+        int output_modes;
+    } isa_instruction;
+
+    /*describes a register: its "name" and "code"*/
+    typedef struct isa_register {
+        const char *name;
+        int code;
+    } isa_register;
+
+    const isa_instruction *isa_instruction_at(int);
+    const isa_instruction *isa_decode_instruction(word);
+    const isa_register *isa_register_at(int);
+    int isa_operand_words(int);
+
+#endif
\ No newline at end of file
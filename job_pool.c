@@ -0,0 +1,472 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <signal.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include "job_pool.h"
+
+/*
+ * This module processes a list of files by several threads at the same time.
+ * each thread has an assembler context of its own (see "assembler_context"),
+ * and whenever it is free takes the next file that was not taken yet, so a
+ * thread which got short files goes on to the next ones while another is still
+ * busy with a long one. the messages each file produces are captured in
+ * memory while it is processed, and printed once it is done, after those of
+ * all the files before it, so the output is grouped by file and ordered as
+ * the command line, exactly as if the files were processed one by one.
+ * the files can be processed by several processes instead, so a file which
+ * crashes the process assembling it does not take the others down with it
+ * (see "run_file_processes").
+ */
+
+/*
+ * the messages of a file: its status messages ("out_text", "out_length") and
+ * its errors ("err_text", "err_length"). "done" is set once it is processed.
+ */
+typedef struct job_result {
+    char *out_text;
+    size_t out_length;
+    char *err_text;
+    size_t err_length;
+    int done;
+} job_result;
+
+/*
+ * "job_names" and "jobs_count": the files being processed, by "job_process".
+ * "results": the messages of each of the files.
+ * "next_job": the index of the next file to be taken by a thread.
+ * "next_to_print": the index of the first file whose messages were not printed.
+ * "pool_lock": guards "next_job", "next_to_print" and the "done" flags.
+ */
+static char **job_names = NULL;
+static int jobs_count = 0;
+static void (*job_process)(char*, int) = NULL;
+static job_result *results = NULL;
+static int next_job = 0;
+static int next_to_print = 0;
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * take_job:
+ * returns the index of the next file to process, or -1 if all were taken.
+ */
+static int take_job(void){
+    int index;
+    pthread_mutex_lock(&pool_lock);
+    index = (next_job < jobs_count) ? next_job++ : -1;
+    pthread_mutex_unlock(&pool_lock);
+    return index;
+}
+
+/*
+ * print_finished_jobs:
+ * prints the messages of the processed files that follow the last printed one,
+ * up to the first one which is not done yet. the caller holds the lock.
+ */
+static void print_finished_jobs(void){
+    while (next_to_print < jobs_count && results[next_to_print].done){
+        job_result *result = results + next_to_print++;
+        fwrite(result->out_text, 1, result->out_length, stdout);
+        fflush(stdout);
+        fwrite(result->err_text, 1, result->err_length, stderr);
+        free(result->out_text);
+        free(result->err_text);
+    }
+}
+
+/*
+ * set_job_error:
+ * sets "result" to the error "text" alone, with no status messages.
+ */
+static void set_job_error(job_result *result, const char *text){
+    result->out_text = NULL;
+    result->out_length = 0;
+    result->err_length = strlen(text);
+    result->err_text = (char*)malloc(result->err_length + 1);
+    if (!result->err_text)
+        exit_program_fatal_error();
+    strcpy(result->err_text, text);
+}
+
+/*
+ * open_job_streams:
+ * initializes "context" to capture the messages of the file at "index" into
+ * "result", returns 1 if so. if the memory streams can't be opened, the file
+ * is not processed: "result" is set to an error naming it and 0 is returned.
+ */
+static int open_job_streams(assembler_context *context, job_result *result, int index){
+    char text[DIAGNOSTIC_SIZE];
+    initialize_context(context);
+    result->out_text = result->err_text = NULL;
+    context->out = open_memstream(&result->out_text, &result->out_length);
+    context->err = open_memstream(&result->err_text, &result->err_length);
+    if (context->out && context->err)
+        return 1;
+    if (context->out)
+        fclose(context->out);
+    if (context->err)
+        fclose(context->err);
+    free(result->out_text);
+    free(result->err_text);
+    initialize_context(context);
+    sprintf(text, "Error: unable to capture the messages of file \"%.*s.as\", it was not processed.\n",
+            DIAGNOSTIC_QUOTE_SIZE, job_names[index]);
+    set_job_error(result, text);
+    return 0;
+}
+
+/*
+ * worker:
+ * the function each thread runs: takes files and processes them with its own
+ * context, capturing their messages, until no file is left.
+ */
+static void *worker(void *unused){
+    assembler_context context;
+    int index;
+    set_current_context(&context);
+    while ((index = take_job()) >= 0){
+        job_result *result = results + index;
+        if (open_job_streams(&context, result, index)){
+            job_process(job_names[index], index);
+            fclose(context.out);
+            fclose(context.err);
+        }
+        pthread_mutex_lock(&pool_lock);
+        result->done = 1;
+        print_finished_jobs();
+        pthread_mutex_unlock(&pool_lock);
+    }
+    set_current_context(NULL);
+    return unused;
+}
+
+/*
+ * "worker_process": a process the files are handed to by "run_file_processes":
+ * "pid" is its process id, it reads the indexes of the files to process from
+ * "tasks" and writes their messages to "results", "job" is the index of the
+ * file it's processing, -1 if none.
+ */
+typedef struct worker_process {
+    pid_t pid;
+    int tasks;
+    int results;
+    int job;
+} worker_process;
+
+/*
+ * "processes" and "processes_count": the workers started by "run_file_processes".
+ */
+static worker_process *processes = NULL;
+static int processes_count = 0;
+
+/*
+ * read_all:
+ * reads exactly "length" characters from "fd" into "data", returns 1 if all were
+ * read, 0 if the file ended or reading failed before that.
+ */
+static int read_all(int fd, void *data, size_t length){
+    char *p = (char*)data;
+    ssize_t count;
+    while (length > 0){
+        if ((count = read(fd, p, length)) <= 0){
+            if (count < 0 && errno == EINTR)
+                continue;
+            return 0;
+        }
+        p += count;
+        length -= count;
+    }
+    return 1;
+}
+
+/*
+ * write_all:
+ * writes the "length" characters of "data" to "fd", returns 1 if all were
+ * written, 0 otherwise.
+ */
+static int write_all(int fd, const void *data, size_t length){
+    const char *p = (const char*)data;
+    ssize_t count;
+    while (length > 0){
+        if ((count = write(fd, p, length)) < 0){
+            if (errno == EINTR)
+                continue;
+            return 0;
+        }
+        p += count;
+        length -= count;
+    }
+    return 1;
+}
+
+/*
+ * process_worker:
+ * the loop a worker process runs: reads the index of a file from "tasks",
+ * processes it capturing its messages, and writes their lengths and then the
+ * messages themselves to "results", until "tasks" is closed. never returns.
+ */
+static void process_worker(int tasks, int results_fd){
+    assembler_context *context = current_context();
+    job_result result;
+    int index;
+    while (read_all(tasks, &index, sizeof(int))){
+        if (open_job_streams(context, &result, index)){
+            job_process(job_names[index], index);
+            fclose(context->out);
+            fclose(context->err);
+            initialize_context(context);
+        }
+        if (!write_all(results_fd, &result.out_length, sizeof(size_t))
+                || !write_all(results_fd, &result.err_length, sizeof(size_t))
+                || !write_all(results_fd, result.out_text, result.out_length)
+                || !write_all(results_fd, result.err_text, result.err_length))
+            break;
+        free(result.out_text);
+        free(result.err_text);
+    }
+    sync_output_directories();
+    _exit(EXIT_SUCCESS);
+}
+
+/*
+ * start_worker:
+ * forks the worker process "worker", connected to the current process by two
+ * pipes, returns 1 if it was started, 0 otherwise. the new process closes the
+ * pipes of the other workers it inherited.
+ */
+static int start_worker(worker_process *worker){
+    int tasks[2], results_fd[2], i;
+    if (pipe(tasks))
+        return 0;
+    if (pipe(results_fd)){
+        close(tasks[0]);
+        close(tasks[1]);
+        return 0;
+    }
+    fflush(stdout);
+    fflush(stderr);
+    if ((worker->pid = fork()) == 0){
+        for (i = 0; i < processes_count; i++)
+            if (processes + i != worker && processes[i].pid > 0){
+                close(processes[i].tasks);
+                close(processes[i].results);
+            }
+        close(tasks[1]);
+        close(results_fd[0]);
+        process_worker(tasks[0], results_fd[1]);
+    }
+    close(tasks[0]);
+    close(results_fd[1]);
+    if (worker->pid < 0){
+        close(tasks[1]);
+        close(results_fd[0]);
+        return 0;
+    }
+    worker->tasks = tasks[1];
+    worker->results = results_fd[0];
+    worker->job = -1;
+    return 1;
+}
+
+/*
+ * stop_worker:
+ * closes the pipes of "worker" and waits for its process to end, returns its
+ * status (see "waitpid").
+ */
+static int stop_worker(worker_process *worker){
+    int status = 0;
+    close(worker->tasks);
+    close(worker->results);
+    while (waitpid(worker->pid, &status, 0) < 0 && errno == EINTR)
+        ;
+    worker->pid = 0;
+    return status;
+}
+
+/*
+ * receive_result:
+ * reads the messages of the file "worker" has processed into its result,
+ * returns 1 if so, 0 if the worker ended before sending all of them.
+ */
+static int receive_result(worker_process *worker){
+    job_result *result = results + worker->job;
+    if (!read_all(worker->results, &result->out_length, sizeof(size_t))
+            || !read_all(worker->results, &result->err_length, sizeof(size_t)))
+        return 0;
+    result->out_text = (char*)malloc(result->out_length + 1);
+    result->err_text = (char*)malloc(result->err_length + 1);
+    if (!result->out_text || !result->err_text)
+        exit_program_fatal_error();
+    if (read_all(worker->results, result->out_text, result->out_length)
+            && read_all(worker->results, result->err_text, result->err_length))
+        return 1;
+    free(result->out_text);
+    free(result->err_text);
+    return 0;
+}
+
+/*
+ * report_crash:
+ * sets the result of the file "worker" was processing when it ended to an
+ * error naming the file, and how its process ended ("status", see "waitpid").
+ */
+static void report_crash(worker_process *worker, int status){
+    job_result *result = results + worker->job;
+    char text[DIAGNOSTIC_SIZE];
+    if (WIFSIGNALED(status))
+        sprintf(text, "Error: processing file \"%.*s.as\" crashed (signal %d).\n",
+                DIAGNOSTIC_QUOTE_SIZE, job_names[worker->job], WTERMSIG(status));
+    else sprintf(text, "Error: processing file \"%.*s.as\" stopped (exit status %d).\n",
+                DIAGNOSTIC_QUOTE_SIZE, job_names[worker->job], WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+    set_job_error(result, text);
+}
+
+/*
+ * assign_job:
+ * hands the next file which was not taken yet to "worker", if any is left,
+ * returns 1 if it was handed over, 0 otherwise. a worker which can't be
+ * written to is restarted and the file is handed to the new process.
+ */
+static int assign_job(worker_process *worker){
+    int index;
+    if (worker->pid <= 0 || (index = take_job()) < 0)
+        return 0;
+    worker->job = index;
+    if (write_all(worker->tasks, &index, sizeof(int)))
+        return 1;
+    stop_worker(worker);
+    if (start_worker(worker)){
+        worker->job = index;
+        if (write_all(worker->tasks, &index, sizeof(int)))
+            return 1;
+    }
+    next_job--;
+    worker->job = -1;
+    return 0;
+}
+
+/*
+ * collect_results:
+ * waits until at least one of the busy workers has processed its file, and
+ * stores the messages of each which did. a worker whose process ended while
+ * processing a file (crashed) has an error stored for that file instead, and
+ * is replaced by a new process. each worker which is done is handed the next
+ * file, and the messages of the files done in order are printed.
+ */
+static void collect_results(struct pollfd *polled, int count){
+    int i;
+    for (i = 0; i < count; i++){
+        polled[i].fd = (processes[i].pid > 0 && processes[i].job >= 0) ? processes[i].results : -1;
+        polled[i].events = POLLIN;
+        polled[i].revents = 0;
+    }
+    if (poll(polled, count, -1) < 0)
+        return;
+    for (i = 0; i < count; i++){
+        worker_process *worker = processes + i;
+        int job = worker->job;
+        if (polled[i].fd < 0 || !polled[i].revents)
+            continue;
+        if (!receive_result(worker)){
+            report_crash(worker, stop_worker(worker));
+            start_worker(worker);
+        }
+        pthread_mutex_lock(&pool_lock);
+        results[job].done = 1;
+        print_finished_jobs();
+        pthread_mutex_unlock(&pool_lock);
+        worker->job = -1;
+        assign_job(worker);
+    }
+}
+
+/*
+ * run_file_processes:
+ * calls "process" on each of the "count" file names in "names", like
+ * "run_file_jobs", but in up to "workers" processes forked from the current
+ * one, each handed the next file over a pipe whenever it is free. a process
+ * which crashes while processing a file only fails that file: an error naming
+ * it is printed in its place and a new process takes over. if no process can
+ * be started, the files left are processed by the current process, like a
+ * thread of "run_file_jobs" would, so their messages are still printed in order.
+ * the builtin symbol table is built before the processes are forked, so they
+ * share it instead of each building its own.
+ */
+void run_file_processes(char **names, int count, int workers, void (*process)(char*, int)){
+    struct pollfd *polled;
+    int i, busy;
+    if (count < 1)
+        return;
+    if (workers > count)
+        workers = count;
+    results = (job_result*)calloc(count, sizeof(job_result));
+    processes = (worker_process*)calloc(workers, sizeof(worker_process));
+    polled = (struct pollfd*)malloc(workers * sizeof(struct pollfd));
+    if (!results || !processes || !polled)
+        exit_program_fatal_error();
+    job_names = names;
+    jobs_count = count;
+    job_process = process;
+    next_job = 0;
+    next_to_print = 0;
+    processes_count = workers;
+    signal(SIGPIPE, SIG_IGN);
+    build_builtin_table();
+    for (i = 0; i < workers; i++)
+        if (start_worker(processes + i))
+            assign_job(processes + i);
+    do {
+        for (i = busy = 0; i < workers; i++)
+            busy += processes[i].pid > 0 && processes[i].job >= 0;
+        if (busy)
+            collect_results(polled, workers);
+    } while (busy);
+    for (i = 0; i < workers; i++)
+        if (processes[i].pid > 0)
+            stop_worker(processes + i);
+    enable_thread_contexts();
+    worker(NULL);
+    free(polled);
+    free(processes);
+    free(results);
+    processes = NULL;
+    results = NULL;
+}
+
+/*
+ * run_file_jobs:
+ * calls "process" on each of the "count" file names in "names", with its index
+ * in "names", by up to "threads" threads at the same time, and returns once all
+ * are processed. the messages of each file are printed in the order of "names". if no thread can
+ * be started, the files are processed by the calling thread.
+ */
+void run_file_jobs(char **names, int count, int threads, void (*process)(char*, int)){
+    pthread_t *workers;
+    int i, started;
+    if (count < 1)
+        return;
+    if (threads > count)
+        threads = count;
+    results = (job_result*)calloc(count, sizeof(job_result));
+    workers = (pthread_t*)malloc(threads * sizeof(pthread_t));
+    if (!results || !workers)
+        exit_program_fatal_error();
+    job_names = names;
+    jobs_count = count;
+    job_process = process;
+    next_job = 0;
+    next_to_print = 0;
+    enable_thread_contexts();
+    for (started = 0; started < threads; started++)
+        if (pthread_create(workers + started, NULL, worker, NULL))
+            break;
+    if (!started)
+        worker(NULL);
+    for (i = 0; i < started; i++)
+        pthread_join(workers[i], NULL);
+    free(workers);
+    free(results);
+    results = NULL;
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#ifndef JOB_POOL_H
+#define JOB_POOL_H
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include "assembler_context.h"
+
+    /*the maximum number of threads or processes files are processed by at the same time*/
+    #define MAX_JOBS 64
+
+    void run_file_jobs(char**, int, int, void (*)(char*, int));
+    void run_file_processes(char**, int, int, void (*)(char*, int));
+
+#endif
\ No newline at end of file
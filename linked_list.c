@@ -45,10 +45,13 @@ node *node_construct(char *key, int type){
  * free_linked_list:
  * this function receives a pointer to a list and frees all the dynamically
  * allocated members of it: the nodes, their data fields and finally the
- * list itself.
+ * list itself. nothing is done if "list" is NULL.
  */
 void free_linked_list(linked_list *list){
-    node *curr = list->head;
+    node *curr;
+    if (!list)
+        return;
+    curr = list->head;
     while(curr) {
         node *temp = curr;
         curr = curr->next;
@@ -1,100 +1,348 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "symbol_table.h"
-#include "memory_manager.h"
-#include "first_pass_processor.h"
-#include "second_pass_processor.h"
-#include "error_handler.h"
+#include "assembler.h"
+#include "encoding_cache.h"
+#include "binary_object.h"
+#include "disassembler.h"
+#include "relocation.h"
+#include "job_pool.h"
+#include "batch.h"
+#include "server.h"
+#include "watch.h"
+#include "prelude.h"
 
-char *add_extension(char*, char*);
-void file_process(char*);
+/*the ways the program can process the command line files*/
+typedef enum run_mode {ASSEMBLE, TO_BINARY, TO_TEXT, TO_SOURCE, TO_PRELUDE, REBASE, BATCH, SERVE, WATCH} run_mode;
+
+void assemble_with_options(char*, int);
+void disassemble_with_options(char*, int);
 void process_files(int, char**);
-void free_string_aray(char**, int);
+int parse_options(int, char**);
+int parse_address(char*, int*);
+int parse_jobs(char*, int*);
+int parse_megabytes(char*, long*);
+int parse_count(char*, long*);
+int parse_seconds(char*, double*);
+void convert_files(int, char**);
+
+/*
+ * "mode": how the files on the command line are processed, set by "-c".
+ * "outputs": the extra files assembled files get: a binary object file, set by "-b",
+ * and a relocation table, set by "-r" (see "assemble_file").
+ * "rebase_address": the base address files are moved to in "REBASE" mode, set by "-R".
+ * "jobs": the number of files assembled at the same time, set by "-j" or "-p".
+ * "isolated": whether the files are assembled by processes rather than threads,
+ * set by "-p".
+ * "manifest": the manifest listing the files to assemble in "BATCH" mode, set by
+ * "-M", and "verbose": whether the status messages of its files are printed, set
+ * by "-v".
+ * "socket_path": the socket the server listens on in "SERVE" mode, set by "-S".
+ * "cache_megabytes": the size the output cache is trimmed to, set by "--cache-size".
+ * "prelude": the prelude snapshot loaded before any file is assembled, set by "-P".
+ * "limits": the limits each file is held to, set by "--max-time", "--max-lines",
+ * "--max-symbols" and "--max-memory" (see the "resource_limits" module).
+ * "memory_megabytes": the memory limit as it's set, in megabytes.
+ */
+static int mode = ASSEMBLE;
+static int outputs = 0;
+static int rebase_address = C;
+static int jobs = 1;
+static int isolated = 0;
+static char *manifest = NULL;
+static int verbose = 0;
+static char *socket_path = NULL;
+static long cache_megabytes = CACHE_DEFAULT_LIMIT;
+static char *prelude = NULL;
+static resource_limits limits;
+static long memory_megabytes = 0;
 
 int main(int argc, char** argv) {    
+    int first;
+    read_output_file_mode();
+    first = parse_options(argc, argv);
+    if (!first || (prelude && !load_prelude(prelude)))
+        return (EXIT_FAILURE);
+    if (mode == WATCH && (jobs > 1 || isolated)){
+        fprintf(stderr, "Error: \"%s\" assembles the files one at a time, \"-j\" and \"-p\" can't be used with it.\n", WATCH_OPTION);
+        return (EXIT_FAILURE);
+    }
+    limits.bytes = memory_megabytes * 1024L * 1024L;
+    set_resource_limits(&limits);
     
-    /*file_process("test");*/
-    /*file_process("test - copy");*/
-    /*process_files(argc, argv);*/
-    
-    char *args[] = {" ", ".\\Examples\\Error_Input_1"};
-    process_files(2, args);
+    if (mode == SERVE)
+        return run_server(socket_path, jobs, outputs) ? EXIT_SUCCESS : EXIT_FAILURE;
+    if (mode == WATCH)
+        run_watch(argv + first, argc - first, outputs);
+    else if (mode == BATCH)
+        run_manifest(manifest, outputs, jobs, verbose);
+    else if (mode == ASSEMBLE){
+        process_files(argc - first + 1, argv + first - 1);
+        trim_output_cache();
+    }
+    else convert_files(argc - first + 1, argv + first - 1);
+    sync_output_directories();
+    free_encoding_cache();
     
     return (EXIT_SUCCESS);
 }
 
 /*
- * add_extension:
- * creates a new string named "output" large enough to hold both "string" and
- * "extension" when combined to one string, and combines them to one string,
- * returning the result string.
+ * parse_options:
+ * goes through the options at the beginning of the command line operands (those
+ * starting with '-') and applies them, returns the index of the first file name.
+ * if an unknown option is found, an error is printed and 0 is returned.
+ * the options are:
+ * "-m": write ".ob" files by mapping them to memory instead of buffering them.
+ * "-d none|file|batch": the durability policy of the output files, "none" by
+ * default (see "durability_policy" in the output buffer header).
+ * "-f awkward|hex|ihex|raw": the format of the output files, "awkward" by default
+ * (see the "output_backend" module).
+ * "-b": also write a binary object file (see the "binary_object" module) for each
+ * assembled file.
+ * "-c binary|text": instead of assembling the files, convert the ".ob", ".ent" and
+ * ".ext" files of each one to a binary object file, or the other way around.
+ * "-c source": instead of assembling the files, disassemble the ".ob", ".ent" and
+ * ".ext" files of each one back to source code (see the "disassembler" module).
+ * "-c prelude": instead of assembling the files, assemble each one as a prelude
+ * of ".extern" declarations into a snapshot file (see the "prelude" module).
+ * "-P snapshot": load the prelude "snapshot", so every file assembled sees its
+ * declarations as if they were at the file's beginning.
+ * "-r": also write a relocation table file (see the "relocation" module) for each
+ * assembled file.
+ * "-R address": instead of assembling the files, move the ".ob", ".ent" and ".ext"
+ * files of each one to the base "address", using their relocation tables.
+ * "-j count": assemble up to "count" files at the same time (see the "job_pool"
+ * module), 1 by default. the messages are printed in the same order either way.
+ * "-c source" disassembles that many files at the same time as well.
+ * "-p count": assemble up to "count" files at the same time by as many processes,
+ * so a file which crashes the assembler fails alone and the others are still
+ * assembled. "-c source" disassembles files by processes as well.
+ * "-M manifest": instead of the files on the command line, assemble the files
+ * listed in "manifest" ("-" for the standard input) and print a summary of the
+ * batch (see the "batch" module). "-j" applies to it, and so does "-p", with
+ * threads instead of processes.
+ * "-v": print the status messages of each file assembled with "-M" as well.
+ * "-S socket": instead of assembling files, serve assembly requests on the UNIX
+ * domain socket "socket" until interrupted (see the "server" module), by as many
+ * threads as "-j" sets. only the user running the server may connect to it,
+ * since its requests read and write files with that user's permissions.
+ * "--watch": assemble the files, and then assemble each again whenever it changes,
+ * until interrupted (see the "watch" module). the files are assembled one at a
+ * time, so "-j" and "-p" can't be used with it.
+ * "-C directory": keep the output files in a cache in "directory", and restore
+ * those of files which were assembled before with the same options instead of
+ * assembling them again (see the "output_cache" module).
+ * "--cache-size megabytes": the size the cache is trimmed to once the files are
+ * assembled, 256 by default.
+ * "--max-time seconds", "--max-lines count", "--max-symbols count" and "--max-memory
+ * megabytes": stop processing a file, as failed, once it takes longer, or has more
+ * lines or symbols, or takes more memory for its contents and symbols, so one
+ * pathological file does not hold the others up. there are no limits by default.
+ * "-I": keep the state the first pass leaves for each file in an IR file next to
+ * it, and restore it instead of running the first pass again while the file does
+ * not change (see the "ir_cache" module).
  */
-char *add_extension(char *string, char *extension){
-    char *output;
-    output = (char*)malloc((1 + strlen(extension)+strlen(string))*sizeof(char));
-    strcpy(output, string);
-    strcat(output, extension);
-    return output;
+int parse_options(int argc, char **argv){
+    int i;
+    for (i = 1; i < argc && argv[i][0] == '-'; i++){
+        if (!strcmp(argv[i], "-m"))
+            set_object_output_mode(MAPPED_OUTPUT);
+        else if (!strcmp(argv[i], "-d") && i + 1 < argc && !strcmp(argv[i + 1], "none"))
+            set_output_durability(NO_SYNC), i++;
+        else if (!strcmp(argv[i], "-d") && i + 1 < argc && !strcmp(argv[i + 1], "file"))
+            set_output_durability(FILE_SYNC), i++;
+        else if (!strcmp(argv[i], "-d") && i + 1 < argc && !strcmp(argv[i + 1], "batch"))
+            set_output_durability(BATCH_SYNC), i++;
+        else if (!strcmp(argv[i], "-f") && i + 1 < argc && select_output_backend(argv[i + 1]))
+            i++;
+        else if (!strcmp(argv[i], "-b"))
+            outputs |= BINARY_OBJECT_OUTPUT;
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc && !strcmp(argv[i + 1], "binary"))
+            mode = TO_BINARY, i++;
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc && !strcmp(argv[i + 1], "text"))
+            mode = TO_TEXT, i++;
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc && !strcmp(argv[i + 1], "source"))
+            mode = TO_SOURCE, i++;
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc && !strcmp(argv[i + 1], "prelude"))
+            mode = TO_PRELUDE, i++;
+        else if (!strcmp(argv[i], "-P") && i + 1 < argc)
+            prelude = argv[++i];
+        else if (!strcmp(argv[i], "-r"))
+            outputs |= RELOCATION_OUTPUT;
+        else if (!strcmp(argv[i], "-R") && i + 1 < argc && parse_address(argv[i + 1], &rebase_address))
+            mode = REBASE, i++;
+        else if (!strcmp(argv[i], "-j") && i + 1 < argc && parse_jobs(argv[i + 1], &jobs))
+            isolated = 0, i++;
+        else if (!strcmp(argv[i], "-p") && i + 1 < argc && parse_jobs(argv[i + 1], &jobs))
+            isolated = 1, i++;
+        else if (!strcmp(argv[i], "-M") && i + 1 < argc)
+            mode = BATCH, manifest = argv[++i];
+        else if (!strcmp(argv[i], "-v"))
+            verbose = 1;
+        else if (!strcmp(argv[i], "-S") && i + 1 < argc)
+            mode = SERVE, socket_path = argv[++i];
+        else if (!strcmp(argv[i], WATCH_OPTION))
+            mode = WATCH;
+        else if (!strcmp(argv[i], "-C") && i + 1 < argc)
+            set_output_cache(argv[++i]);
+        else if (!strcmp(argv[i], "--cache-size") && i + 1 < argc && parse_megabytes(argv[i + 1], &cache_megabytes))
+            set_output_cache_limit(cache_megabytes), i++;
+        else if (!strcmp(argv[i], "-I"))
+            set_ir_cache(1);
+        else if (!strcmp(argv[i], "--max-time") && i + 1 < argc && parse_seconds(argv[i + 1], &limits.seconds))
+            i++;
+        else if (!strcmp(argv[i], "--max-lines") && i + 1 < argc && parse_count(argv[i + 1], &limits.lines))
+            i++;
+        else if (!strcmp(argv[i], "--max-symbols") && i + 1 < argc && parse_count(argv[i + 1], &limits.symbols))
+            i++;
+        else if (!strcmp(argv[i], "--max-memory") && i + 1 < argc && parse_count(argv[i + 1], &memory_megabytes))
+            i++;
+        else {
+            fprintf(stderr, "Error: unknown option \"%s\".\n", argv[i]);
+            return 0;
+        }
+    }
+    return i;
 }
 
 /*
- * file_process:
- * takes "filename" string which does not include the ".as"  extension at its end 
- * adds the extensions, using "add_extension" function.
- * it then loads the different components required for input processing: symbols table,
- * memory, file pointers and second pass lists, then calls the first and second
- * pass processors. if no errors were detected by either of the processors the output
- * files are produced. the ".ob" and ".ext" are guaranteed to be error free if the
- * program decides to produce them, the ".ent" file creator might still report an error
- * and will not be produced if a certain ".entry" directive's label (operand) was
- * not defined in the input file. if there was a problem opening the input file,
- * an error is printed to stderr.
+ * parse_address:
+ * stores the decimal number in "text" in "address" if it is a valid memory
+ * address (0 to 1023), returns 1 if so, 0 otherwise.
  */
-void file_process(char *filename){
-    int status = 1;
-    char *files_names[4];
-    if (load_input_file(files_names[0] = add_extension(filename, ".as"))){
-        initialize_symbol_table();
-        initialize_memory();    
-        initialize_second_pass_lists();
-        status = first_pass_process() && second_pass_process() && !get_memmory_full_flag();
-        if (status){
-            save_memory_to_file(files_names[1] = add_extension(filename, ".ob"));
-            create_entries_file(files_names[2] = add_extension(filename, ".ent"));
-            create_externs_files(files_names[3] = add_extension(filename, ".ext"));
-            free_string_aray(files_names, 4);
-        }        
-        free_symbol_table();
-        free_memory();
-        close_input_file();
-        free_second_pass_lists();
-    }
-    else fprintf(stderr, "Error: unable to open file \"%s\".\n", filename);
+int parse_address(char *text, int *address){
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (!*text || *end || value < 0 || value >= AWKWARD_VALUES)
+        return 0;
+    *address = (int)value;
+    return 1;
+}
+
+/*
+ * parse_jobs:
+ * stores the decimal number in "text" in "count" if it is a valid number of
+ * files to assemble at the same time (1 to MAX_JOBS), returns 1 if so, 0
+ * otherwise.
+ */
+int parse_jobs(char *text, int *count){
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (!*text || *end || value < 1 || value > MAX_JOBS)
+        return 0;
+    *count = (int)value;
+    return 1;
+}
+
+/*
+ * parse_megabytes:
+ * stores the decimal number in "text" in "megabytes" if it is a valid size (0
+ * or more), returns 1 if so, 0 otherwise.
+ */
+int parse_megabytes(char *text, long *megabytes){
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (!*text || *end || value < 0)
+        return 0;
+    *megabytes = value;
+    return 1;
+}
+
+/*
+ * parse_count:
+ * stores the decimal number in "text" in "count" if it is a valid limit (1 or
+ * more), returns 1 if so, 0 otherwise.
+ */
+int parse_count(char *text, long *count){
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (!*text || *end || value < 1)
+        return 0;
+    *count = value;
+    return 1;
+}
+
+/*
+ * parse_seconds:
+ * stores the number in "text" in "seconds" if it is a valid time limit (more
+ * than 0), returns 1 if so, 0 otherwise.
+ */
+int parse_seconds(char *text, double *seconds){
+    char *end;
+    double value = strtod(text, &end);
+    if (!*text || *end || !(value > 0))
+        return 0;
+    *seconds = value;
+    return 1;
+}
+
+/*
+ * assemble_with_options:
+ * assembles "filename" with the extra outputs selected on the command line
+ * (see the "assembler" module). its position among the operands, "index", is
+ * not needed.
+ */
+void assemble_with_options(char *filename, int index){
+    (void)index;
+    assemble_file(filename, outputs);
 }
 
 /*
  * process_files:
- * this function goes through the command line operands and calls "file_process"
- * on each, starting from the first to the last.
+ * this function goes through the command line operands and calls "assemble_with_options"
+ * on each, starting from the first to the last, or has them assembled by "jobs"
+ * threads when "-j" is given, or by "jobs" processes when "-p" is given.
  */
 void process_files(int argc, char** argv){
     int i = argc;
-    while (0 < --i){
-        fprintf(stdout, "\nProcessing file \"%s.as\"...\n\n", argv[argc - i]);
-        file_process(argv[argc - i]);
-        fprintf(stdout, "\nDone processing file \"%s.as\".\n\n", argv[argc - i]);
+    if (isolated){
+        run_file_processes(argv + 1, argc - 1, jobs, assemble_with_options);
+        return;
+    }
+    if (jobs > 1){
+        run_file_jobs(argv + 1, argc - 1, jobs, assemble_with_options);
+        return;
     }
+    while (0 < --i)
+        assemble_with_options(argv[argc - i], argc - i - 1);
 }
 
 /*
- * free_string_aray:
- * frees each of the character pointers (strings) in "array" with
- * a given size, assumes that the pointers were assigned dynamically.
+ * disassemble_with_options:
+ * disassembles the output files of "name" (see the "disassembler" module). its
+ * position among the operands, "index", is not needed.
  */
-void free_string_aray(char **array, int size){
+void disassemble_with_options(char *name, int index){
+    (void)index;
+    disassemble_file(name);
+}
+
+/*
+ * convert_files:
+ * goes through the command line operands, like "process_files", and converts
+ * the output files of each between the text and binary object formats, or
+ * to source code, or moves them to another base address, or assembles each
+ * as a prelude. files are disassembled to source code by "jobs" threads or
+ * processes, like "process_files" assembles them, the other conversions are
+ * done one file at a time.
+ */
+void convert_files(int argc, char** argv){
     int i;
-    for(i = 0; i < size; i++)
-        free(array[i]);
+    if (mode == TO_SOURCE && isolated){
+        run_file_processes(argv + 1, argc - 1, jobs, disassemble_with_options);
+        return;
+    }
+    if (mode == TO_SOURCE && jobs > 1){
+        run_file_jobs(argv + 1, argc - 1, jobs, disassemble_with_options);
+        return;
+    }
+    for (i = 1; i < argc; i++){
+        if (mode == TO_BINARY) convert_text_to_binary(argv[i]);
+        else if (mode == TO_TEXT) convert_binary_to_text(argv[i]);
+        else if (mode == TO_SOURCE) disassemble_file(argv[i]);
+        else if (mode == TO_PRELUDE) make_prelude(argv[i]);
+        else rebase_file(argv[i], rebase_address);
+    }
 }
     
@@ -1,10 +1,11 @@
-#include "memory_manager.h"
+#define _POSIX_C_SOURCE 200112L
+#include "assembler_context.h"
 
 /*
  * This module defines an object which resembles the imaginary computer's
- * memory. there's only one instant running, so there's no need to create
- * copies of the object, therefore static variables are used to store the 
- * state of the memory. this object is created and destroyed for each new
+ * memory. the state of the memory is kept in the assembler context each of
+ * the functions receives (see "assembler_context"), so each thread works on
+ * the memory of its own file. this object is created and destroyed for each new
  * file that requires processing, it includes two data arrays that stores
  * "words", one for instructions and one for the data, the user is responsible
  * for making sure the data stored is not corrupt. this module is responsible
@@ -13,19 +14,10 @@
  */
 
 /*
- * "instructions_array": this array stores the words which belong to instructions.
- * "data_array": this array stores the words that belong to directives.
- * "IC" and "DC": are counters that store the next available index in each
- * of the arrays.
- * "memory_full_flag" indicates whether the assembler tried to add a new word
- * to one of the arrays when the maximum total count has already been reached,
- * in other words, the memory was full.
+ * "output_mode" is the way the ".ob" file is written, it is set once for all
+ * the files by "set_object_output_mode" and is not reset by "free_memory".
  */
-static word *instructions_array = NULL;
-static word *data_array = NULL;
-static int IC = 0;
-static int DC = 0;
-static int memory_full_flag = 0;
+static int output_mode = BUFFERED_OUTPUT;
 
 /*
  * initialize_memory:
@@ -33,10 +25,10 @@ static int memory_full_flag = 0;
  * should be called before beginning to process a new file.
  * "calloc" is used to make sure all members are initially set to 0.
  */
-void initialize_memory(void){
-    instructions_array = (word*)calloc(MEMORY_SIZE, sizeof(word));
-    data_array = (word*)calloc(MEMORY_SIZE, sizeof(word));
-    if (!(instructions_array && data_array))
+void initialize_memory(assembler_context *context){
+    context->memory.instructions_array = (word*)calloc(MEMORY_SIZE, sizeof(word));
+    context->memory.data_array = (word*)calloc(MEMORY_SIZE, sizeof(word));
+    if (!(context->memory.instructions_array && context->memory.data_array))
         exit_program_fatal_error();
 }
 
@@ -45,14 +37,14 @@ void initialize_memory(void){
  * should be called when file processing is done, frees the arrays and
  * makes sure all the file's variables are set to zero or NULL.
  */
-void free_memory(void){
-    free(instructions_array);
-    free(data_array);
-    instructions_array = NULL;
-    data_array = NULL;
-    IC = 0;
-    DC = 0;
-    memory_full_flag = 0;
+void free_memory(assembler_context *context){
+    free(context->memory.instructions_array);
+    free(context->memory.data_array);
+    context->memory.instructions_array = NULL;
+    context->memory.data_array = NULL;
+    context->memory.IC = 0;
+    context->memory.DC = 0;
+    context->memory.memory_full_flag = 0;
 }
 
 /*
@@ -60,8 +52,8 @@ void free_memory(void){
  * returns the current value of IC (which is also the count of the words
  * stored in the instructions array).
  */
-int get_ic(void){
-    return IC;
+int get_ic(assembler_context *context){
+    return context->memory.IC;
 }
 
 /*
@@ -69,8 +61,8 @@ int get_ic(void){
  * returns the current value of DC (which is also the count of the words
  * stored in the data array).
  */
-int get_dc(void){
-    return DC;
+int get_dc(assembler_context *context){
+    return context->memory.DC;
 }
 
 /*
@@ -80,12 +72,12 @@ int get_dc(void){
  * stderr, but the program will continue to run.
  * the total count is the total number of members in both arrays.
  */
-void instructions_array_insert(word item){
-    if (IC + DC <= MEMORY_SIZE)
-        instructions_array[IC++] = item;
+void instructions_array_insert(assembler_context *context, word item){
+    if (context->memory.IC + context->memory.DC < MEMORY_SIZE)
+        context->memory.instructions_array[context->memory.IC++] = item;
     else {
-        memory_full_flag = 1;
-        fprintf(stderr, "Error: memory is full.\n");        
+        context->memory.memory_full_flag = 1;
+        report_diagnostic(0, 0, 0, "Error: memory is full.");        
     }
 }
 
@@ -96,12 +88,12 @@ void instructions_array_insert(word item){
  * stderr, but the program will continue to run.
  * the total count is the total number of members in both arrays.
  */
-void data_array_insert(word item){
-    if (IC + DC <= MEMORY_SIZE)
-        data_array[DC++] = item;
+void data_array_insert(assembler_context *context, word item){
+    if (context->memory.IC + context->memory.DC < MEMORY_SIZE)
+        context->memory.data_array[context->memory.DC++] = item;
     else {
-        memory_full_flag = 1;
-        fprintf(stderr, "Error: memory is full.\n");        
+        context->memory.memory_full_flag = 1;
+        report_diagnostic(0, 0, 0, "Error: memory is full.");        
     }
 }
 
@@ -111,10 +103,31 @@ void data_array_insert(word item){
  * by the second pass processor to update the addresses of data and
  * external variables passed as operands to instructions.
  */
-void instructions_array_set_index(int index, int address){
+void instructions_array_set_index(assembler_context *context, int index, int address){
     word temp_word;
     temp_word.value = address;
-    instructions_array[index] = temp_word;
+    context->memory.instructions_array[index] = temp_word;
+}
+
+/*
+ * instructions_array_get_index:
+ * returns the word stored at "index" in the instructions array, the caller
+ * makes sure "index" is less than IC.
+ */
+word instructions_array_get_index(assembler_context *context, int index){
+    return context->memory.instructions_array[index];
+}
+
+/*
+ * memory_image:
+ * describes the memory's contents in "image", for the output formats.
+ */
+static void memory_image(assembler_context *context, object_image *image){
+    image->instructions = context->memory.instructions_array;
+    image->ic = context->memory.IC;
+    image->data = context->memory.data_array;
+    image->dc = context->memory.DC;
+    image->base = C;
 }
 
 /*
@@ -127,32 +140,82 @@ void instructions_array_set_index(int index, int address){
  * and the word itself.
  * the data array is then traversed and the index count is continued from where
  * it stopped in the instructions array, therefore, IC is added.
- * if there was a problem creating the output object file, an error is reported.
- */
-void save_memory_to_file(char *filename){
-    int i;
-    FILE *output = fopen(filename, "w");
-    if (output){
-        char temp_str[3] = "";    
-        fprintf(output, "%s\t", convert_int_to_awkward_base(IC, temp_str));
-        fprintf(output, "%s", convert_int_to_awkward_base(DC, temp_str));    
-        for (i = 0; i < IC; i++){
-            fprintf(output, "\n%s\t", convert_int_to_awkward_base(C + i, temp_str));
-            fprintf(output, "%s", convert_to_awkward_base(instructions_array[i], temp_str));
+ * other output formats can be selected (see the "output_backend" module), all
+ * of which have a size known in advance, so the file is encoded by the format's
+ * "encode_object" into a block of that exact size: in "BUFFERED_OUTPUT" mode a buffer which is written at once, and in
+ * "MAPPED_OUTPUT" mode the file itself, mapped to memory. if there was a problem
+ * creating the output object file, an error is reported.
+ */
+void save_memory_to_file(assembler_context *context, char *filename){
+    const output_backend *backend = get_output_backend();
+    object_image image;
+    size_t size;
+    memory_image(context, &image);
+    size = backend->object_size(&image);
+    if (output_mode == MAPPED_OUTPUT){
+        mapped_file output;
+        if (mapped_file_open(&output, filename, size)){
+            backend->encode_object(output.text, &image);
+            mapped_file_close(&output);
         }
-        for (i = 0; i < DC ; i++){
-            fprintf(output, "\n%s\t", convert_int_to_awkward_base(C + i + IC, temp_str));
-            fprintf(output, "%s", convert_to_awkward_base(data_array[i], temp_str));       
-        }        
-        fclose(output);       
     }
-    else fprintf(stderr, "Error: unable to create the file \"%s\".\n", filename);
+    else {
+        output_buffer output;
+        save_memory_to_buffer(context, &output);
+        output_buffer_write_file(&output, filename);
+        output_buffer_free(&output);
+    }
+}
+
+/*
+ * save_memory_to_buffer:
+ * initializes "output" with the object file "save_memory_to_file" would write,
+ * in the selected output format, for the caller to use and free.
+ */
+void save_memory_to_buffer(assembler_context *context, output_buffer *output){
+    const output_backend *backend = get_output_backend();
+    object_image image;
+    size_t size;
+    memory_image(context, &image);
+    size = backend->object_size(&image);
+    output_buffer_init(output, size);
+    backend->encode_object(output_buffer_extend(output, size), &image);
+}
+
+/*
+ * save_memory_to_binary_file:
+ * creates the binary object file named "filename" with the contents of the two
+ * arrays, and the entries and externs records built in "entries" and "externs"
+ * (see the "binary_object" module). the file is built in a buffer of its exact
+ * size and written at once. if there was a problem creating the file, an error
+ * is reported.
+ */
+void save_memory_to_binary_file(assembler_context *context, char *filename, output_buffer *entries, output_buffer *externs){
+    output_buffer output;
+    output_buffer_init(&output, BINARY_HEADER_SIZE + (context->memory.IC + context->memory.DC) * BINARY_WORD_SIZE + entries->length + externs->length);
+    encode_binary_header((unsigned char*)output_buffer_extend(&output, BINARY_HEADER_SIZE), context->memory.IC, context->memory.DC, C,
+            entries->length / BINARY_SYMBOL_SIZE, externs->length / BINARY_SYMBOL_SIZE);
+    encode_binary_words((unsigned char*)output_buffer_extend(&output, context->memory.IC * BINARY_WORD_SIZE), context->memory.instructions_array, context->memory.IC);
+    encode_binary_words((unsigned char*)output_buffer_extend(&output, context->memory.DC * BINARY_WORD_SIZE), context->memory.data_array, context->memory.DC);
+    output_buffer_append(&output, entries->text, entries->length);
+    output_buffer_append(&output, externs->text, externs->length);
+    output_buffer_write_file(&output, filename);
+    output_buffer_free(&output);
+}
+
+/*
+ * set_object_output_mode:
+ * sets the way ".ob" files are written: "BUFFERED_OUTPUT" (the default) or
+ * "MAPPED_OUTPUT".
+ */
+void set_object_output_mode(int mode){
+    output_mode = mode;
 }
 
 /*
  * get_memory_full_flag:
  * returns the memory status flag.
  */
-int get_memmory_full_flag(void){
-    return memory_full_flag;
+int get_memmory_full_flag(assembler_context *context){
+    return context->memory.memory_full_flag;
 }
\ No newline at end of file
@@ -4,20 +4,48 @@
     #include <stdio.h>
     #include <stdlib.h>
     #include "symbol_table.h"
+    #include "output_buffer.h"
+    #include "binary_object.h"
+    #include "output_backend.h"
 
     /*the starting index of the memory list*/
     #define C 100
     /*the maximum total items allowed in both instructions and data arrays*/
     #define MEMORY_SIZE 256
+
+    /*the ways the ".ob" file can be written*/
+    typedef enum object_output_mode {BUFFERED_OUTPUT, MAPPED_OUTPUT} object_output_mode;
+
+    /*
+     * the memory of the file being processed:
+     * "instructions_array": this array stores the words which belong to instructions.
+     * "data_array": this array stores the words that belong to directives.
+     * "IC" and "DC": are counters that store the next available index in each
+     * of the arrays.
+     * "memory_full_flag" indicates whether the assembler tried to add a new word
+     * to one of the arrays when the maximum total count has already been reached,
+     * in other words, the memory was full.
+     */
+    typedef struct memory_state {
+        word *instructions_array;
+        word *data_array;
+        int IC;
+        int DC;
+        int memory_full_flag;
+    } memory_state;
     
-    void initialize_memory(void);
-    void free_memory(void);
-    int get_ic(void);
-    int get_dc(void);
-    void instructions_array_insert(word);
-    void data_array_insert(word);
-    void save_memory_to_file(char*);
-    int get_memmory_full_flag(void);
-    void instructions_array_set_index(int, int);
+    void initialize_memory(assembler_context*);
+    void free_memory(assembler_context*);
+    int get_ic(assembler_context*);
+    int get_dc(assembler_context*);
+    void instructions_array_insert(assembler_context*, word);
+    void data_array_insert(assembler_context*, word);
+    void save_memory_to_file(assembler_context*, char*);
+    void save_memory_to_buffer(assembler_context*, output_buffer*);
+    void set_object_output_mode(int);
+    void save_memory_to_binary_file(assembler_context*, char*, output_buffer*, output_buffer*);
+    int get_memmory_full_flag(assembler_context*);
+    void instructions_array_set_index(assembler_context*, int, int);
+    word instructions_array_get_index(assembler_context*, int);
 
 #endif
\ No newline at end of file
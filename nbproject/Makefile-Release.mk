@@ -35,14 +35,32 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 
 # Object Files
 OBJECTFILES= \
+	${OBJECTDIR}/assembler.o \
+	${OBJECTDIR}/assembler_context.o \
+	${OBJECTDIR}/batch.o \
+	${OBJECTDIR}/binary_object.o \
+	${OBJECTDIR}/disassembler.o \
+	${OBJECTDIR}/encoding_cache.o \
 	${OBJECTDIR}/error_handler.o \
 	${OBJECTDIR}/first_pass_processor.o \
 	${OBJECTDIR}/hash_table.o \
+	${OBJECTDIR}/ir_cache.o \
+	${OBJECTDIR}/isa.o \
+	${OBJECTDIR}/job_pool.o \
 	${OBJECTDIR}/linked_list.o \
 	${OBJECTDIR}/main.o \
 	${OBJECTDIR}/memory_manager.o \
+	${OBJECTDIR}/object_reader.o \
+	${OBJECTDIR}/output_backend.o \
+	${OBJECTDIR}/output_buffer.o \
+	${OBJECTDIR}/output_cache.o \
+	${OBJECTDIR}/prelude.o \
+	${OBJECTDIR}/relocation.o \
+	${OBJECTDIR}/resource_limits.o \
 	${OBJECTDIR}/second_pass_processor.o \
+	${OBJECTDIR}/server.o \
 	${OBJECTDIR}/symbol_table.o \
+	${OBJECTDIR}/watch.o \
 	${OBJECTDIR}/word.o
 
 
@@ -60,7 +78,7 @@ FFLAGS=
 ASFLAGS=
 
 # Link Libraries and Options
-LDLIBSOPTIONS=
+LDLIBSOPTIONS=-lpthread
 
 # Build Targets
 .build-conf: ${BUILD_SUBPROJECTS}
@@ -70,6 +88,36 @@ ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/assembler-project.exe: ${OBJECTFILES}
 	${MKDIR} -p ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}
 	${LINK.c} -o ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/assembler-project ${OBJECTFILES} ${LDLIBSOPTIONS}
 
+${OBJECTDIR}/assembler.o: assembler.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/assembler.o assembler.c
+
+${OBJECTDIR}/assembler_context.o: assembler_context.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/assembler_context.o assembler_context.c
+
+${OBJECTDIR}/batch.o: batch.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/batch.o batch.c
+
+${OBJECTDIR}/binary_object.o: binary_object.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/binary_object.o binary_object.c
+
+${OBJECTDIR}/disassembler.o: disassembler.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/disassembler.o disassembler.c
+
+${OBJECTDIR}/encoding_cache.o: encoding_cache.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/encoding_cache.o encoding_cache.c
+
 ${OBJECTDIR}/error_handler.o: error_handler.c
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
@@ -85,6 +133,21 @@ ${OBJECTDIR}/hash_table.o: hash_table.c
 	${RM} "$@.d"
 	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/hash_table.o hash_table.c
 
+${OBJECTDIR}/ir_cache.o: ir_cache.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/ir_cache.o ir_cache.c
+
+${OBJECTDIR}/isa.o: isa.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/isa.o isa.c
+
+${OBJECTDIR}/job_pool.o: job_pool.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/job_pool.o job_pool.c
+
 ${OBJECTDIR}/linked_list.o: linked_list.c
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
@@ -100,16 +163,61 @@ ${OBJECTDIR}/memory_manager.o: memory_manager.c
 	${RM} "$@.d"
 	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/memory_manager.o memory_manager.c
 
+${OBJECTDIR}/object_reader.o: object_reader.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/object_reader.o object_reader.c
+
+${OBJECTDIR}/output_backend.o: output_backend.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/output_backend.o output_backend.c
+
+${OBJECTDIR}/output_buffer.o: output_buffer.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/output_buffer.o output_buffer.c
+
+${OBJECTDIR}/output_cache.o: output_cache.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/output_cache.o output_cache.c
+
+${OBJECTDIR}/prelude.o: prelude.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/prelude.o prelude.c
+
+${OBJECTDIR}/relocation.o: relocation.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/relocation.o relocation.c
+
+${OBJECTDIR}/resource_limits.o: resource_limits.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/resource_limits.o resource_limits.c
+
 ${OBJECTDIR}/second_pass_processor.o: second_pass_processor.c
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
 	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/second_pass_processor.o second_pass_processor.c
 
+${OBJECTDIR}/server.o: server.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/server.o server.c
+
 ${OBJECTDIR}/symbol_table.o: symbol_table.c
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
 	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/symbol_table.o symbol_table.c
 
+${OBJECTDIR}/watch.o: watch.c
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -std=c89 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/watch.o watch.c
+
 ${OBJECTDIR}/word.o: word.c
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
@@ -0,0 +1,197 @@
+#define _POSIX_C_SOURCE 200112L
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "object_reader.h"
+
+/*
+ * This module implements a reader of the assembler's output files, for tools
+ * that look up single addresses or symbols without parsing the whole text:
+ * the ".ob" file is mapped to memory and, since every line after the header
+ * has the same width, the word at any address is found at a computed offset
+ * and decoded through the "awkward base" reverse table. opening a file only
+ * validates its header and size. the ".ent" and ".ext" files are indexed by
+ * sorting their symbols by name, so symbols are found by binary search.
+ */
+
+/*
+ * compare_symbols:
+ * orders symbol records by name, and records of the same name by address,
+ * for "qsort" and "bsearch".
+ */
+static int compare_symbols(const void *first, const void *second){
+    int result = strcmp((const char*)first, (const char*)second);
+    if (!result){
+        char name[BINARY_NAME_SIZE];
+        result = binary_symbol_read((const unsigned char*)first, name)
+               - binary_symbol_read((const unsigned char*)second, name);
+    }
+    return result;
+}
+
+/*
+ * compare_names:
+ * compares the name "key" to the name of a symbol record, for "bsearch".
+ */
+static int compare_names(const void *key, const void *record){
+    return strcmp((const char*)key, (const char*)record);
+}
+
+/*
+ * index_symbols:
+ * loads the symbols of the ".ent" or ".ext" file named "name" followed by
+ * "extension" into "table" sorted by name. returns their number, 0 if the
+ * file does not exist, or -1 if it is not in the expected format.
+ */
+static int index_symbols(char *name, char *extension, output_buffer *table){
+    char *filename = (char*)malloc(strlen(name) + strlen(extension) + 1);
+    int count;
+    if (!filename)
+        exit_program_fatal_error();
+    strcpy(filename, name);
+    strcat(filename, extension);
+    output_buffer_init(table, 0);
+    count = binary_symbols_parse(filename, table);
+    if (count > 0)
+        qsort(table->text, count, BINARY_SYMBOL_SIZE, compare_symbols);
+    else if (count < 0)
+        fprintf(error_output(), "Error: \"%s\" is not a valid symbols file.\n", filename);
+    free(filename);
+    return count;
+}
+
+/*
+ * map_object_file:
+ * maps the ".ob" file of the program "name" to "reader" and validates its
+ * header: the file's size must match IC and DC, and the first line's address
+ * is taken as the base. returns 1 on success, otherwise an error is printed
+ * and 0 is returned.
+ */
+static int map_object_file(object_reader *reader, char *name){
+    char *filename = (char*)malloc(strlen(name) + 4);
+    struct stat info;
+    void *text = MAP_FAILED;
+    int fd, status = 0;
+    if (!filename)
+        exit_program_fatal_error();
+    strcpy(filename, name);
+    strcat(filename, ".ob");
+    if ((fd = open(filename, O_RDONLY)) < 0)
+        fprintf(error_output(), "Error: unable to open file \"%s\".\n", filename);
+    else {
+        if (!fstat(fd, &info) && info.st_size >= AWKWARD_LINE_SIZE - 1)
+            text = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (text != MAP_FAILED){
+            reader->text = (const char*)text;
+            reader->size = info.st_size;
+            reader->ic = decode_awkward_word(reader->text);
+            reader->dc = decode_awkward_word(reader->text + AWKWARD_WORD_SIZE + 1);
+            reader->base = (reader->size > AWKWARD_LINE_SIZE) ? decode_awkward_word(reader->text + AWKWARD_LINE_SIZE) : 0;
+            status = reader->ic >= 0 && reader->dc >= 0 && reader->base >= 0
+                    && reader->text[AWKWARD_WORD_SIZE] == '\t'
+                    && reader->size == AWKWARD_LINE_SIZE - 1 + (size_t)(reader->ic + reader->dc) * AWKWARD_LINE_SIZE;
+            if (!status)
+                munmap(text, info.st_size);
+        }
+        if (!status)
+            fprintf(error_output(), "Error: \"%s\" is not a valid object file.\n", filename);
+    }
+    free(filename);
+    return status;
+}
+
+/*
+ * object_reader_open:
+ * opens the output files of the program "name" (given without an extension):
+ * maps its ".ob" file, and indexes its ".ent" and ".ext" files, which may be
+ * missing. returns 1 on success, otherwise an error is printed and 0 is returned.
+ */
+int object_reader_open(object_reader *reader, char *name){
+    reader->text = NULL;
+    if (!map_object_file(reader, name))
+        return 0;
+    reader->entries_count = index_symbols(name, ".ent", &reader->entries);
+    reader->externs_count = index_symbols(name, ".ext", &reader->externs);
+    if (reader->entries_count < 0 || reader->externs_count < 0){
+        object_reader_close(reader);
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * object_reader_close:
+ * unmaps the files opened by "object_reader_open" and frees the symbols.
+ */
+void object_reader_close(object_reader *reader){
+    if (reader->text){
+        munmap((void*)reader->text, reader->size);
+        output_buffer_free(&reader->entries);
+        output_buffer_free(&reader->externs);
+    }
+    reader->text = NULL;
+}
+
+/*
+ * object_reader_word:
+ * returns the 10 bits value of the word at "address", or -1 if the file has
+ * no word at that address or the word's line is corrupt. addresses are 10 bits
+ * long, so they wrap around after 1023, like in the file.
+ */
+int object_reader_word(const object_reader *reader, int address){
+    int index = (address - reader->base) & (AWKWARD_VALUES - 1);
+    const char *line = reader->text + AWKWARD_LINE_SIZE - 1 + (size_t)index * AWKWARD_LINE_SIZE;
+    if (address < 0 || address >= AWKWARD_VALUES || index >= reader->ic + reader->dc
+            || line[0] != '\n' || line[AWKWARD_WORD_SIZE + 1] != '\t')
+        return -1;
+    return decode_awkward_word(line + AWKWARD_WORD_SIZE + 2);
+}
+
+/*
+ * object_reader_range:
+ * decodes the "count" words starting at "address" into "target". returns the
+ * number of words decoded, which is less than "count" if the file ends first
+ * or a corrupt line is found.
+ */
+int object_reader_range(const object_reader *reader, int address, int count, word *target){
+    int i, value = 0;
+    for (i = 0; i < count && (value = object_reader_word(reader, (address + i) & (AWKWARD_VALUES - 1))) >= 0; i++)
+        target[i].value = value;
+    return i;
+}
+
+/*
+ * object_reader_entry:
+ * returns the address of the entry symbol "name", or -1 if there is no such entry.
+ */
+int object_reader_entry(const object_reader *reader, char *name){
+    char found[BINARY_NAME_SIZE];
+    const unsigned char *record = (const unsigned char*)bsearch(name, reader->entries.text,
+            reader->entries_count, BINARY_SYMBOL_SIZE, compare_names);
+    return record ? binary_symbol_read(record, found) : -1;
+}
+
+/*
+ * object_reader_extern_uses:
+ * stores the addresses where the extern symbol "name" is used, in increasing
+ * order, in "addresses", up to "max" of them. returns the number of uses,
+ * which may be greater than "max", or 0 if the symbol is not used.
+ */
+int object_reader_extern_uses(const object_reader *reader, char *name, int *addresses, int max){
+    char found[BINARY_NAME_SIZE];
+    const unsigned char *first = (const unsigned char*)reader->externs.text;
+    const unsigned char *last = first + (size_t)reader->externs_count * BINARY_SYMBOL_SIZE;
+    const unsigned char *record = (const unsigned char*)bsearch(name, first, reader->externs_count,
+            BINARY_SYMBOL_SIZE, compare_names);
+    int count = 0;
+    if (!record)
+        return 0;
+    while (record > first && !strcmp(name, (const char*)record - BINARY_SYMBOL_SIZE))
+        record -= BINARY_SYMBOL_SIZE;
+    for (; record < last && !strcmp(name, (const char*)record); record += BINARY_SYMBOL_SIZE, count++)
+        if (count < max)
+            addresses[count] = binary_symbol_read(record, found);
+    return count;
+}
\ No newline at end of file
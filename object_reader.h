@@ -0,0 +1,37 @@
+#ifndef OBJECT_READER_H
+#define OBJECT_READER_H
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include "word.h"
+    #include "output_buffer.h"
+    #include "binary_object.h"
+
+    /*
+     * an assembled program's ".ob" file mapped to memory for random access:
+     * "text" holds the file's "size" characters, "ic", "dc" and "base" (the
+     * first address) are read from it. "entries" and "externs" hold the records
+     * of the ".ent" and ".ext" files (in the binary object format), sorted by
+     * name, "entries_count" and "externs_count" are their numbers.
+     */
+    typedef struct object_reader {
+        const char *text;
+        size_t size;
+        int ic;
+        int dc;
+        int base;
+        output_buffer entries;
+        int entries_count;
+        output_buffer externs;
+        int externs_count;
+    } object_reader;
+
+    int object_reader_open(object_reader*, char*);
+    void object_reader_close(object_reader*);
+    int object_reader_word(const object_reader*, int);
+    int object_reader_range(const object_reader*, int, int, word*);
+    int object_reader_entry(const object_reader*, char*);
+    int object_reader_extern_uses(const object_reader*, char*, int*, int);
+
+#endif
\ No newline at end of file
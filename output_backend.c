@@ -0,0 +1,239 @@
+#include "output_backend.h"
+
+/*
+ * This module implements the output formats the assembler can write its files
+ * in, each as an "output_backend": the "awkward base" text the imaginary
+ * computer's loader reads, plain hexadecimal text, Intel HEX and raw words.
+ * all the formats have a fixed size for a given number of words, so an object
+ * file is always encoded into a block of its exact size, and each word is
+ * encoded through a table generated at compile time. the formats are listed in
+ * the "backends" table and one of them is selected for all the files processed.
+ */
+
+/*
+ * the hexadecimal digits, in order. "HEX_ROW" lists the 16 pairs whose first
+ * digit is "first", and "HEX_TABLE" lists the rows for every first digit, so
+ * the 2 digits of all the 256 byte values are generated in order, as a list of
+ * characters, like the "awkward base" pairs (see the "word" module).
+ */
+#define HEX_DIGITS(X) X('0') X('1') X('2') X('3') X('4') X('5') X('6') X('7') \
+                      X('8') X('9') X('A') X('B') X('C') X('D') X('E') X('F')
+#define HEX_ROW(first) first, '0', first, '1', first, '2', first, '3', first, '4', first, '5', \
+                       first, '6', first, '7', first, '8', first, '9', first, 'A', first, 'B', \
+                       first, 'C', first, 'D', first, 'E', first, 'F',
+#define HEX_TABLE {HEX_DIGITS(HEX_ROW)}
+
+/*the 2 hexadecimal digits of each byte "b" are at indexes 2b and 2b+1*/
+static const char hex_pairs[2 * 256] = HEX_TABLE;
+
+/*
+ * encode_hex_byte:
+ * writes the 2 hexadecimal digits of the byte "value" to "target".
+ */
+static void encode_hex_byte(int value, char *target){
+    const char *pair = hex_pairs + 2 * (value & 0xFF);
+    target[0] = pair[0];
+    target[1] = pair[1];
+}
+
+/*
+ * encode_hex_word:
+ * writes the 3 hexadecimal digits of the first 10 bits of "value" to "target".
+ */
+static void encode_hex_word(int value, char *target){
+    target[0] = hex_pairs[2 * ((value >> 8) & 3) + 1];
+    encode_hex_byte(value, target + 1);
+}
+
+/*
+ * image_word:
+ * returns the 10 bits value of the word at memory index "index" of "image",
+ * where the data words follow the instructions words.
+ */
+static int image_word(const object_image *image, int index){
+    const word *item = (index < image->ic) ? image->instructions + index : image->data + index - image->ic;
+    return item->value & (AWKWARD_VALUES - 1);
+}
+
+/*
+ * awkward_object_size:
+ * returns the size of the "awkward base" object file of "image": a header line
+ * with IC and DC, and a line with the address and the word for each word.
+ */
+static size_t awkward_object_size(const object_image *image){
+    return OBJECT_HEADER_SIZE + (size_t)(image->ic + image->dc) * AWKWARD_LINE_SIZE;
+}
+
+/*
+ * encode_awkward_range:
+ * encodes the object file lines of the words at memory indexes "first" up to
+ * (not including) "last" of "image" into "text", which holds the whole object
+ * file. every line has the same width, so the lines are written straight to
+ * their final position and disjoint ranges can be encoded independently, in
+ * any order.
+ */
+static void encode_awkward_range(char *text, const object_image *image, int first, int last){
+    char *target = text + OBJECT_HEADER_SIZE + first * AWKWARD_LINE_SIZE;
+    int ic = image->ic;
+    if (first < ic)
+        target = encode_object_lines(target, image->instructions + first, (last < ic ? last : ic) - first, image->base + first);
+    if (last > ic){
+        int start = (first > ic) ? first : ic;
+        encode_object_lines(target, image->data + start - ic, last - start, image->base + start);
+    }
+}
+
+/*
+ * encode_awkward_object:
+ * encodes the whole "awkward base" object file of "image" into "text".
+ */
+static void encode_awkward_object(char *text, const object_image *image){
+    encode_awkward_word(image->ic, text);
+    text[AWKWARD_WORD_SIZE] = '\t';
+    encode_awkward_word(image->dc, text + AWKWARD_WORD_SIZE + 1);
+    encode_awkward_range(text, image, 0, image->ic + image->dc);
+}
+
+/*
+ * hex_object_size:
+ * returns the size of the hexadecimal object file of "image", which has the
+ * same lines as the "awkward base" one, with 3 digits for each word.
+ */
+static size_t hex_object_size(const object_image *image){
+    return HEX_LINE_SIZE - 1 + (size_t)(image->ic + image->dc) * HEX_LINE_SIZE;
+}
+
+/*
+ * encode_hex_object:
+ * encodes the whole hexadecimal object file of "image" into "text".
+ */
+static void encode_hex_object(char *text, const object_image *image){
+    int i, count = image->ic + image->dc;
+    encode_hex_word(image->ic, text);
+    text[HEX_WORD_SIZE] = '\t';
+    encode_hex_word(image->dc, text + HEX_WORD_SIZE + 1);
+    text += HEX_LINE_SIZE - 1;
+    for (i = 0; i < count; i++, text += HEX_LINE_SIZE){
+        text[0] = '\n';
+        encode_hex_word(image->base + i, text + 1);
+        text[HEX_WORD_SIZE + 1] = '\t';
+        encode_hex_word(image_word(image, i), text + HEX_WORD_SIZE + 2);
+    }
+}
+
+/*
+ * append_hex_symbol:
+ * appends a line of the ".ent" or ".ext" files with a hexadecimal address to
+ * "buffer": the symbol's name "key", a space, "address" and a new line.
+ */
+static void append_hex_symbol(output_buffer *buffer, char *key, int address){
+    char *target;
+    output_buffer_append_string(buffer, key);
+    target = output_buffer_extend(buffer, HEX_WORD_SIZE + 2);
+    target[0] = ' ';
+    encode_hex_word(address, target + 1);
+    target[HEX_WORD_SIZE + 1] = '\n';
+}
+
+/*
+ * ihex_object_size:
+ * returns the size of the Intel HEX object file of "image": its words take 2
+ * bytes each, little endian, in records of up to IHEX_RECORD_BYTES bytes
+ * followed by the end of file record.
+ */
+static size_t ihex_object_size(const object_image *image){
+    size_t bytes = (size_t)(image->ic + image->dc) * 2;
+    size_t records = (bytes + IHEX_RECORD_BYTES - 1) / IHEX_RECORD_BYTES;
+    return (records + 1) * IHEX_RECORD_OVERHEAD + 2 * bytes;
+}
+
+/*
+ * encode_ihex_object:
+ * encodes the whole Intel HEX object file of "image" into "text". each word
+ * occupies 2 bytes, so the record addresses are twice the words addresses,
+ * starting at the image's base.
+ */
+static void encode_ihex_object(char *text, const object_image *image){
+    int bytes = (image->ic + image->dc) * 2, offset, i;
+    for (offset = 0; offset < bytes; offset += IHEX_RECORD_BYTES){
+        int count = (bytes - offset < IHEX_RECORD_BYTES) ? bytes - offset : IHEX_RECORD_BYTES;
+        int address = image->base * 2 + offset;
+        int checksum = count + (address >> 8) + (address & 0xFF);
+        text[0] = ':';
+        encode_hex_byte(count, text + 1);
+        encode_hex_byte(address >> 8, text + 3);
+        encode_hex_byte(address, text + 5);
+        encode_hex_byte(0, text + 7);
+        text += 9;
+        for (i = 0; i < count; i++, text += 2){
+            int value = image_word(image, (offset + i) / 2);
+            int byte = ((offset + i) % 2) ? value >> 8 : value & 0xFF;
+            encode_hex_byte(byte, text);
+            checksum += byte;
+        }
+        encode_hex_byte(-checksum, text);
+        text[2] = '\n';
+        text += 3;
+    }
+    memcpy(text, IHEX_END_RECORD, IHEX_RECORD_OVERHEAD);
+}
+
+/*
+ * raw_object_size:
+ * returns the size of the raw object file of "image": 2 bytes for each word.
+ */
+static size_t raw_object_size(const object_image *image){
+    return (size_t)(image->ic + image->dc) * 2;
+}
+
+/*
+ * encode_raw_object:
+ * encodes the words of "image" into "text" as unsigned 16 bits numbers in
+ * little endian order.
+ */
+static void encode_raw_object(char *text, const object_image *image){
+    int i, count = image->ic + image->dc;
+    for (i = 0; i < count; i++, text += 2){
+        int value = image_word(image, i);
+        text[0] = (char)(value & 0xFF);
+        text[1] = (char)(value >> 8);
+    }
+}
+
+/*
+ * the available output formats, the first is the default. Intel HEX and raw
+ * object files hold no symbols, so their ".ent" and ".ext" files have
+ * hexadecimal addresses.
+ */
+static const output_backend backends[] = {
+    {"awkward", ".ob", awkward_object_size, encode_awkward_object, output_buffer_append_symbol},
+    {"hex", ".obh", hex_object_size, encode_hex_object, append_hex_symbol},
+    {"ihex", ".hex", ihex_object_size, encode_ihex_object, append_hex_symbol},
+    {"raw", ".bin", raw_object_size, encode_raw_object, append_hex_symbol}
+};
+
+/*the selected output format*/
+static const output_backend *current_backend = backends;
+
+/*
+ * select_output_backend:
+ * selects the output format named "name" for all the files written from now
+ * on. returns 1 on success, or 0 if there is no such format.
+ */
+int select_output_backend(const char *name){
+    size_t i;
+    for (i = 0; i < sizeof(backends) / sizeof(backends[0]); i++)
+        if (!strcmp(backends[i].name, name)){
+            current_backend = backends + i;
+            return 1;
+        }
+    return 0;
+}
+
+/*
+ * get_output_backend:
+ * returns the selected output format.
+ */
+const output_backend *get_output_backend(void){
+    return current_backend;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef OUTPUT_BACKEND_H
+#define OUTPUT_BACKEND_H
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include "word.h"
+    #include "output_buffer.h"
+
+    /*the characters in an "awkward base" object file's first line: 2 words and a tab*/
+    #define OBJECT_HEADER_SIZE (2 * AWKWARD_WORD_SIZE + 1)
+    /*the number of hexadecimal digits in a 10 bits word*/
+    #define HEX_WORD_SIZE 3
+    /*the characters in a hexadecimal object file line: 2 words, a tab and a new line*/
+    #define HEX_LINE_SIZE (2 * HEX_WORD_SIZE + 2)
+    /*the maximum number of data bytes in an Intel HEX record*/
+    #define IHEX_RECORD_BYTES 16
+    /*the characters in an Intel HEX record besides its data: ':', count, address, type, checksum and new line*/
+    #define IHEX_RECORD_OVERHEAD 12
+    /*the Intel HEX end of file record*/
+    #define IHEX_END_RECORD ":00000001FF\n"
+
+    /*
+     * the contents of memory an object file is made of: "ic" words in
+     * "instructions" followed by "dc" words in "data", the first of which
+     * is at address "base".
+     */
+    typedef struct object_image {
+        const word *instructions;
+        int ic;
+        const word *data;
+        int dc;
+        int base;
+    } object_image;
+
+    /*
+     * an output format: its "name" on the command line, the extension of its
+     * object file, "object_size" returns the exact size of the object file of
+     * an image, "encode_object" writes it to a block of that size, and
+     * "append_symbol" appends a line of the ".ent" or ".ext" files.
+     */
+    typedef struct output_backend {
+        const char *name;
+        const char *object_extension;
+        size_t (*object_size)(const object_image*);
+        void (*encode_object)(char*, const object_image*);
+        void (*append_symbol)(output_buffer*, char*, int);
+    } output_backend;
+
+    int select_output_backend(const char*);
+    const output_backend *get_output_backend(void);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,448 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "output_buffer.h"
+
+/*
+ * This module implements the buffers the output files are built in: each of
+ * the ".ob", ".ent" and ".ext" files is assembled in one contiguous block of
+ * memory, and once complete, is written to its file with a single "write"
+ * call, instead of formatting and writing each word through the standard
+ * input/output library. the words are encoded to the "awkward base" directly
+ * in the buffer. alternatively, a file whose exact size is known in advance
+ * can be mapped to memory and filled in place.
+ * the files are written under unique temporary names and renamed once
+ * complete, so an output file is either whole or absent even if several
+ * programs write it at the same time, and are synchronized to the disk
+ * according to the durability policy. a file of up to "DIRECT_WRITE_SIZE"
+ * characters, which a single "write" call completes, is written under its
+ * own name instead, unless the durability policy requires synchronizing it.
+ */
+
+/*
+ * "durability": the policy for synchronizing the output files to the disk.
+ * "pending_directories": the names of the directories files were published to,
+ * which "sync_output_directories" should synchronize in "BATCH_SYNC" policy.
+ * "pending_count" is the number of names stored and "pending_capacity" the
+ * number of names allocated. "pending_lock" guards the list, since files are
+ * published by several threads at the same time.
+ * "file_mode": the permissions the output files are created with, set by
+ * "read_output_file_mode".
+ */
+static int durability = NO_SYNC;
+static char **pending_directories = NULL;
+static int pending_count = 0;
+static int pending_capacity = 0;
+static pthread_mutex_t pending_lock = PTHREAD_MUTEX_INITIALIZER;
+static mode_t file_mode = 0644;
+
+/*
+ * reserve:
+ * makes sure "buffer" has room for "count" more characters, doubling its
+ * capacity as many times as needed.
+ */
+static void reserve(output_buffer *buffer, size_t count){
+    size_t capacity = buffer->capacity;
+    char *temp;
+    if (buffer->length + count <= capacity)
+        return;
+    while (buffer->length + count > capacity)
+        capacity *= 2;
+    temp = (char*)realloc(buffer->text, capacity);
+    if (!temp){
+        exit_program_fatal_error();
+        return;
+    }
+    buffer->text = temp;
+    buffer->capacity = capacity;
+}
+
+/*
+ * output_buffer_init:
+ * allocates an empty buffer which can hold "capacity" characters before it
+ * needs to grow, INITIAL_OUTPUT_CAPACITY is used if "capacity" is 0. when the
+ * size of the output is known in advance, passing it avoids any reallocation.
+ */
+void output_buffer_init(output_buffer *buffer, size_t capacity){
+    if (!capacity)
+        capacity = INITIAL_OUTPUT_CAPACITY;
+    buffer->text = (char*)malloc(capacity);
+    if (!buffer->text)
+        exit_program_fatal_error();
+    buffer->length = 0;
+    buffer->capacity = capacity;
+}
+
+/*
+ * output_buffer_extend:
+ * adds "count" characters to the end of the buffer and returns a pointer to
+ * the first of them, for the caller to fill.
+ */
+char *output_buffer_extend(output_buffer *buffer, size_t count){
+    char *target;
+    reserve(buffer, count);
+    target = buffer->text + buffer->length;
+    buffer->length += count;
+    return target;
+}
+
+/*
+ * output_buffer_append:
+ * appends the first "count" characters of "text" to the buffer.
+ */
+void output_buffer_append(output_buffer *buffer, const char *text, size_t count){
+    reserve(buffer, count);
+    memcpy(buffer->text + buffer->length, text, count);
+    buffer->length += count;
+}
+
+/*
+ * output_buffer_append_string:
+ * appends the null terminated string "text" to the buffer, without the
+ * terminating character.
+ */
+void output_buffer_append_string(output_buffer *buffer, const char *text){
+    output_buffer_append(buffer, text, strlen(text));
+}
+
+/*
+ * output_buffer_append_char:
+ * appends the character "c" to the buffer.
+ */
+void output_buffer_append_char(output_buffer *buffer, char c){
+    reserve(buffer, 1);
+    buffer->text[buffer->length++] = c;
+}
+
+/*
+ * output_buffer_append_word:
+ * appends the "awkward base" encoding of the first 10 bits of "value" to the
+ * buffer.
+ */
+void output_buffer_append_word(output_buffer *buffer, int value){
+    encode_awkward_word(value, output_buffer_extend(buffer, AWKWARD_WORD_SIZE));
+}
+
+/*
+ * read_output_file_mode:
+ * stores in "file_mode" the permissions "open" gives the files it creates,
+ * under the program's file mode creation mask. reading the mask changes it
+ * for a moment, so this should be called once, before any thread starts.
+ */
+void read_output_file_mode(void){
+    mode_t mask = umask(0);
+    umask(mask);
+    file_mode = 0666 & ~mask;
+}
+
+/*
+ * create_temp_file:
+ * creates the temporary file "filename" is written to before it is published,
+ * under a unique name in the same directory, with the permissions "open" would
+ * give it. stores a new string with its name in "temp" and returns its
+ * descriptor, or returns -1 if it could not be created, in which case "temp"
+ * is set to NULL.
+ */
+static int create_temp_file(char *filename, char **temp){
+    int fd;
+    if (!(*temp = (char*)malloc(strlen(filename) + strlen(TEMP_SUFFIX) + 1)))
+        exit_program_fatal_error();
+    strcpy(*temp, filename);
+    strcat(*temp, TEMP_SUFFIX);
+    if ((fd = mkstemp(*temp)) < 0){
+        free(*temp);
+        *temp = NULL;
+        return -1;
+    }
+    fchmod(fd, file_mode);
+    return fd;
+}
+
+/*
+ * directory_name:
+ * returns a new string with the name of the directory the file "filename"
+ * is in, "." if "filename" includes no directory.
+ */
+static char *directory_name(char *filename){
+    char *slash = strrchr(filename, '/'), *backslash = strrchr(filename, '\\');
+    char *name;
+    size_t length;
+    if (!slash || (backslash && backslash > slash))
+        slash = backslash;
+    if (!slash){
+        filename = ".";
+        length = 1;
+    }
+    else length = (slash == filename) ? 1 : slash - filename;
+    name = (char*)malloc(length + 1);
+    if (!name)
+        return exit_program_fatal_error();
+    memcpy(name, filename, length);
+    name[length] = '\0';
+    return name;
+}
+
+/*
+ * sync_directory:
+ * synchronizes the directory named "name" to the disk, so the files renamed
+ * in it are found under their new names after a crash. systems which cannot
+ * synchronize a directory are ignored.
+ */
+static void sync_directory(char *name){
+    int fd = open(name, O_RDONLY);
+    if (fd >= 0){
+        fsync(fd);
+        close(fd);
+    }
+}
+
+/*
+ * add_pending_directory:
+ * adds the directory of "filename" to the directories that will be synchronized
+ * by "sync_output_directories", unless it is already there.
+ */
+static void add_pending_directory(char *filename){
+    char *name = directory_name(filename);
+    int i;
+    pthread_mutex_lock(&pending_lock);
+    for (i = 0; i < pending_count && strcmp(pending_directories[i], name); i++)
+        ;
+    if (i < pending_count)
+        free(name);
+    else {
+        if (pending_count == pending_capacity){
+            int capacity = pending_capacity ? 2 * pending_capacity : INITIAL_PENDING_DIRECTORIES;
+            char **temp = (char**)realloc(pending_directories, capacity * sizeof(char*));
+            if (!temp)
+                exit_program_fatal_error();
+            pending_directories = temp;
+            pending_capacity = capacity;
+        }
+        pending_directories[pending_count++] = name;
+    }
+    pthread_mutex_unlock(&pending_lock);
+}
+
+/*
+ * publish_file:
+ * completes writing the temporary file "temp" whose descriptor is "fd": unless
+ * an error occurred while writing it ("status" is 0), the file is synchronized
+ * to the disk as the durability policy requires, closed and renamed to
+ * "filename", replacing any older file with that name at once, so a partially
+ * written file is never found under "filename". if anything failed, the
+ * temporary file is removed and an error is reported. frees "temp" and returns
+ * 1 on success, 0 otherwise.
+ */
+static int publish_file(int fd, int status, char *temp, char *filename){
+    if (status && durability != NO_SYNC)
+        status = !fsync(fd);
+    status = !close(fd) && status;
+    status = status && !rename(temp, filename);
+    if (status){
+        if (durability == FILE_SYNC){
+            char *name = directory_name(filename);
+            sync_directory(name);
+            free(name);
+        }
+        else if (durability == BATCH_SYNC)
+            add_pending_directory(filename);
+    }
+    else {
+        remove(temp);
+        fprintf(error_output(), "Error: unable to write the file \"%s\".\n", filename);
+    }
+    free(temp);
+    return status;
+}
+
+/*
+ * write_all:
+ * writes the first "length" characters of "text" to the file whose descriptor
+ * is "fd", repeating the call only if the system wrote part of them. returns 1
+ * on success, 0 otherwise.
+ */
+static int write_all(int fd, const char *text, size_t length){
+    size_t written = 0;
+    while (written < length){
+        ssize_t result = write(fd, text + written, length - written);
+        if (result <= 0)
+            return 0;
+        written += result;
+    }
+    return 1;
+}
+
+/*
+ * output_buffer_append_symbol:
+ * appends a line of the ".ent" or ".ext" files to the buffer: the symbol's
+ * name "key", a space and "address" in the "awkward base".
+ */
+void output_buffer_append_symbol(output_buffer *buffer, char *key, int address){
+    output_buffer_append_string(buffer, key);
+    output_buffer_append_char(buffer, ' ');
+    output_buffer_append_word(buffer, address);
+    output_buffer_append_char(buffer, '\n');
+}
+
+/*
+ * write_file_directly:
+ * writes the buffer's contents to the file named "filename" under its own
+ * name, for small files which are not synchronized. the old file is removed
+ * first, so a file it was a hard link of (see the "output_cache" module) is
+ * left as it was. returns 1 on success, otherwise the error is reported and
+ * 0 is returned.
+ */
+static int write_file_directly(output_buffer *buffer, char *filename){
+    int status, fd;
+    remove(filename);
+    if ((fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666)) < 0){
+        fprintf(error_output(), "Error: unable to create the file \"%s\".\n", filename);
+        return 0;
+    }
+    status = write_all(fd, buffer->text, buffer->length);
+    if (!(status = !close(fd) && status)){
+        remove(filename);
+        fprintf(error_output(), "Error: unable to write the file \"%s\".\n", filename);
+    }
+    return status;
+}
+
+/*
+ * output_buffer_write_file:
+ * writes the buffer's contents to the file named "filename", through a
+ * temporary file which replaces it once complete (see "publish_file"), or
+ * directly if it's small and the durability policy is "NO_SYNC". the
+ * contents are written with one call, which is repeated only if the system
+ * wrote part of them. returns 1 on success, otherwise the error is reported
+ * and 0 is returned.
+ */
+int output_buffer_write_file(output_buffer *buffer, char *filename){
+    char *temp;
+    int fd;
+    if (durability == NO_SYNC && buffer->length <= DIRECT_WRITE_SIZE)
+        return write_file_directly(buffer, filename);
+    fd = create_temp_file(filename, &temp);
+    if (fd < 0){
+        fprintf(error_output(), "Error: unable to create the file \"%s\".\n", filename);
+        return 0;
+    }
+    return publish_file(fd, write_all(fd, buffer->text, buffer->length), temp, filename);
+}
+
+/*
+ * output_buffer_read_file:
+ * initializes the buffer with the whole contents of the file named "filename".
+ * returns 1 on success, or 0 if the file could not be opened, in which case the
+ * buffer is left empty.
+ */
+int output_buffer_read_file(output_buffer *buffer, char *filename){
+    FILE *file = fopen(filename, "rb");
+    output_buffer_init(buffer, 0);
+    if (!file)
+        return 0;
+    output_buffer_read_stream(buffer, file);
+    fclose(file);
+    return 1;
+}
+
+/*
+ * output_buffer_read_stream:
+ * appends everything left to read from "file" to the buffer, which should be
+ * initialized already.
+ */
+void output_buffer_read_stream(output_buffer *buffer, FILE *file){
+    size_t count;
+    do {
+        char *target = output_buffer_extend(buffer, INITIAL_OUTPUT_CAPACITY);
+        count = fread(target, 1, INITIAL_OUTPUT_CAPACITY, file);
+        buffer->length -= INITIAL_OUTPUT_CAPACITY - count;
+    } while (count == INITIAL_OUTPUT_CAPACITY);
+}
+
+/*
+ * output_buffer_free:
+ * frees the buffer's contents, it can be initialized again afterwards.
+ */
+void output_buffer_free(output_buffer *buffer){
+    free(buffer->text);
+    buffer->text = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+}
+
+/*
+ * mapped_file_open:
+ * creates a temporary file for the file named "filename", sets its size to
+ * "length" characters and maps it to memory, for the caller to fill. returns
+ * the mapped text, which is also stored in "file", or NULL if the file could
+ * not be created, in which case an error is reported. an empty file is not
+ * mapped, and an empty text is returned for it.
+ */
+char *mapped_file_open(mapped_file *file, char *filename, size_t length){
+    file->text = NULL;
+    file->length = length;
+    file->filename = filename;
+    file->fd = create_temp_file(filename, &file->temp);
+    if (file->fd >= 0 && !ftruncate(file->fd, length)){
+        void *text;
+        if (!length)
+            return file->text = "";
+        text = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, file->fd, 0);
+        if (text != MAP_FAILED)
+            return file->text = (char*)text;
+    }
+    fprintf(error_output(), "Error: unable to create the file \"%s\".\n", filename);
+    if (file->fd >= 0){
+        close(file->fd);
+        remove(file->temp);
+    }
+    free(file->temp);
+    file->temp = NULL;
+    return NULL;
+}
+
+/*
+ * mapped_file_close:
+ * unmaps the file opened by "mapped_file_open" and publishes it under its
+ * name (see "publish_file"). returns 1 on success, otherwise the error is
+ * reported and 0 is returned.
+ */
+int mapped_file_close(mapped_file *file){
+    int status = !file->length || !munmap(file->text, file->length);
+    file->text = NULL;
+    status = publish_file(file->fd, status, file->temp, file->filename);
+    file->temp = NULL;
+    return status;
+}
+
+/*
+ * set_output_durability:
+ * sets the way the output files are synchronized to the disk: "NO_SYNC" (the
+ * default), "FILE_SYNC" or "BATCH_SYNC", as described in the header.
+ */
+void set_output_durability(int policy){
+    durability = policy;
+}
+
+/*
+ * sync_output_directories:
+ * synchronizes each directory files were published to since the last call,
+ * once, and clears the list. does nothing unless the durability policy is
+ * "BATCH_SYNC". should be called after all the files are processed.
+ */
+void sync_output_directories(void){
+    int i;
+    pthread_mutex_lock(&pending_lock);
+    for (i = 0; i < pending_count; i++){
+        sync_directory(pending_directories[i]);
+        free(pending_directories[i]);
+    }
+    free(pending_directories);
+    pending_directories = NULL;
+    pending_count = 0;
+    pending_capacity = 0;
+    pthread_mutex_unlock(&pending_lock);
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include "word.h"
+    #include "error_handler.h"
+
+    /*the initial number of characters allocated for a buffer, doubled as needed*/
+    #define INITIAL_OUTPUT_CAPACITY 256
+    /*the initial number of directories names allocated for batch synchronization*/
+    #define INITIAL_PENDING_DIRECTORIES 4
+    /*
+     * the suffix added to a file's name while it is being written, its X's are
+     * replaced by "mkstemp" so each writer of the file gets a temporary file of
+     * its own
+     */
+    #define TEMP_SUFFIX ".tmp.XXXXXX"
+    /*the largest file written under its own name when it's not synchronized*/
+    #define DIRECT_WRITE_SIZE 4096
+
+    /*
+     * the policies for synchronizing the output files to the disk: "NO_SYNC"
+     * leaves it to the system, "FILE_SYNC" synchronizes each file and then its
+     * directory once it is renamed, and "BATCH_SYNC" synchronizes each file but
+     * synchronizes each directory only once, when "sync_output_directories"
+     * is called.
+     */
+    typedef enum durability_policy {NO_SYNC, FILE_SYNC, BATCH_SYNC} durability_policy;
+
+    /*
+     * the whole contents of an output file: "text" holds "length" characters
+     * out of the "capacity" allocated, it is not null terminated.
+     */
+    typedef struct output_buffer {
+        char *text;
+        size_t length;
+        size_t capacity;
+    } output_buffer;
+
+    /*
+     * an output file mapped to memory: "text" holds the file's "length"
+     * characters, "fd" is the descriptor of the temporary file named "temp"
+     * and "filename" is the name it is published under.
+     */
+    typedef struct mapped_file {
+        char *text;
+        size_t length;
+        int fd;
+        char *temp;
+        char *filename;
+    } mapped_file;
+
+    void output_buffer_init(output_buffer*, size_t);
+    char *output_buffer_extend(output_buffer*, size_t);
+    void output_buffer_append(output_buffer*, const char*, size_t);
+    void output_buffer_append_string(output_buffer*, const char*);
+    void output_buffer_append_char(output_buffer*, char);
+    void output_buffer_append_word(output_buffer*, int);
+    void output_buffer_append_symbol(output_buffer*, char*, int);
+    int output_buffer_write_file(output_buffer*, char*);
+    int output_buffer_read_file(output_buffer*, char*);
+    void output_buffer_read_stream(output_buffer*, FILE*);
+    void output_buffer_free(output_buffer*);
+    char *mapped_file_open(mapped_file*, char*, size_t);
+    int mapped_file_close(mapped_file*);
+    void read_output_file_mode(void);
+    void set_output_durability(int);
+    void sync_output_directories(void);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,406 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "output_cache.h"
+#include "memory_manager.h"
+#include "prelude.h"
+#include "resource_limits.h"
+
+/*
+ * This module keeps the output files of the files assembled in a cache on the
+ * disk, so a file which was assembled before, with the same contents and the
+ * same options, is not assembled again: its output files are restored from the
+ * cache instead. each entry of the cache is a directory, named after a hash of
+ * the source, the options and the assembler's version (the key), holding a copy
+ * of each output file, named after its extension, and the messages printed
+ * while it was assembled, which are printed again when it's restored. the copies
+ * are hard links to the output files where possible, which is safe since output
+ * files are always replaced and never changed in place. an entry is stored under
+ * a temporary name and then renamed, so it is complete once it can be found. the
+ * cache is trimmed to its size limit by "trim_output_cache", removing the entries
+ * which were used least recently first. the example "Cached_Input_1.as" is the
+ * same as "Correct_Input_1.as", so assembled after it with a cache, its output
+ * files are restored from the entry of the other, the same as the ones kept
+ * next to it.
+ */
+
+/*
+ * "cache_directory": the directory of the cache, NULL if there's no cache.
+ * "cache_limit": the size the cache is trimmed to, in bytes.
+ * "statistics": the counts of the cache's use, guarded by "statistics_lock"
+ * since files may be assembled by several threads.
+ */
+static char *cache_directory = NULL;
+static long cache_limit = CACHE_DEFAULT_LIMIT * 1024L * 1024L;
+static cache_statistics statistics;
+static pthread_mutex_t statistics_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * count_use:
+ * adds "count" to the statistic "counter".
+ */
+static void count_use(int *counter, int count){
+    pthread_mutex_lock(&statistics_lock);
+    *counter += count;
+    pthread_mutex_unlock(&statistics_lock);
+}
+
+/*
+ * join_path:
+ * returns a new string naming the file "file" in the directory "directory".
+ */
+static char *join_path(const char *directory, const char *file){
+    char *path = (char*)malloc(strlen(directory) + strlen(file) + 2);
+    if (!path)
+        return exit_program_fatal_error();
+    sprintf(path, "%s/%s", directory, file);
+    return path;
+}
+
+/*
+ * extension_of:
+ * returns the extension of the output file named "name", without the dot.
+ */
+static const char *extension_of(const char *name){
+    const char *dot = strrchr(name, '.');
+    return dot ? dot + 1 : name;
+}
+
+/*
+ * copy_file:
+ * makes the file named "target" the same as the file named "source": as a
+ * hard link to it if possible, or as a copy. returns 1 on success, 0 otherwise.
+ */
+static int copy_file(const char *source, const char *target){
+    output_buffer contents;
+    int status;
+    remove(target);
+    if (!link(source, target))
+        return 1;
+    if (!output_buffer_read_file(&contents, (char*)source))
+        return 0;
+    status = output_buffer_write_file(&contents, (char*)target);
+    output_buffer_free(&contents);
+    return status;
+}
+
+/*
+ * print_stored:
+ * prints the contents of the file named "path", if it exists, to "stream".
+ */
+static void print_stored(const char *path, FILE *stream){
+    output_buffer contents;
+    if (output_buffer_read_file(&contents, (char*)path))
+        fwrite(contents.text, 1, contents.length, stream);
+    output_buffer_free(&contents);
+}
+
+/*
+ * store_text:
+ * writes the "length" characters of "text" to the file named "path", returns
+ * 1 on success, 0 otherwise.
+ */
+static int store_text(const char *path, const char *text, size_t length){
+    FILE *file = fopen(path, "wb");
+    int status;
+    if (!file)
+        return 0;
+    status = fwrite(text, 1, length, file) == length;
+    return !fclose(file) && status;
+}
+
+/*
+ * remove_entry:
+ * removes the entry directory named "path" with the files in it.
+ */
+static void remove_entry(const char *path){
+    DIR *directory = opendir(path);
+    struct dirent *item;
+    char *file;
+    if (directory){
+        while ((item = readdir(directory))){
+            if (!strcmp(item->d_name, ".") || !strcmp(item->d_name, ".."))
+                continue;
+            remove(file = join_path(path, item->d_name));
+            free(file);
+        }
+        closedir(directory);
+    }
+    rmdir(path);
+}
+
+/*
+ * set_output_cache:
+ * keeps the output files in the cache directory "directory", which is created
+ * if it does not exist.
+ */
+void set_output_cache(char *directory){
+    cache_directory = directory;
+    mkdir(directory, 0777);
+}
+
+/*
+ * set_output_cache_limit:
+ * sets the size the cache is trimmed to, to "megabytes".
+ */
+void set_output_cache_limit(long megabytes){
+    cache_limit = megabytes * 1024L * 1024L;
+}
+
+/*
+ * output_cache_enabled:
+ * returns 1 if the output files are kept in a cache, 0 otherwise.
+ */
+int output_cache_enabled(void){
+    return cache_directory != NULL;
+}
+
+/*
+ * hash_source_key:
+ * stores in "key" (OUTPUT_KEY_SIZE characters) two 32 bits hashes (FNV-1a and
+ * a variant of djb2) of the line "options" followed by the "length" characters
+ * of "source", in hexadecimal.
+ */
+void hash_source_key(const char *options, const char *source, size_t length, char *key){
+    unsigned long first = 2166136261UL, second = 5381UL;
+    size_t i, options_length = strlen(options);
+    for (i = 0; i < options_length + length; i++){
+        unsigned char c = (unsigned char)(i < options_length ? options[i] : source[i - options_length]);
+        first = ((first ^ c) * 16777619UL) & 0xFFFFFFFFUL;
+        second = ((second * 33) ^ c) & 0xFFFFFFFFUL;
+    }
+    sprintf(key, "%08lx%08lx", first, second);
+}
+
+/*
+ * output_cache_key:
+ * stores in "key" (OUTPUT_KEY_SIZE characters) the key of the entry of the
+ * "length" characters of "source", assembled with the extra "outputs" (see
+ * "assemble_file"), the current output format, prelude and resource limits
+ * (a file may fail under some limits only): the hash of the source and a line
+ * naming the version and the options.
+ */
+void output_cache_key(const char *source, size_t length, int outputs, char *key){
+    char options[256];
+    sprintf(options, "%s %s %d %d %lu %s %s\n", CACHE_VERSION, get_output_backend()->name, outputs, C, (unsigned long)length,
+            get_prelude_key(), get_limits_key());
+    hash_source_key(options, source, length, key);
+}
+
+/*
+ * output_cache_restore:
+ * restores the "count" output files named in "names" from the entry "key", and
+ * prints the messages stored with it and sets "lines" to the number of lines
+ * stored with it. an output file which the entry does not hold (like a ".ent"
+ * file of a source without entries) is removed. returns 1 if the entry was
+ * found and restored, 0 otherwise.
+ */
+int output_cache_restore(const char *key, char **names, int count, int *lines){
+    output_buffer contents;
+    struct stat info;
+    char *entry, *path;
+    int i, status = 1;
+    if (!cache_directory)
+        return 0;
+    entry = join_path(cache_directory, key);
+    if (stat(entry, &info) || !S_ISDIR(info.st_mode)){
+        count_use(&statistics.misses, 1);
+        free(entry);
+        return 0;
+    }
+    for (i = 0; i < count && status; i++){
+        path = join_path(entry, extension_of(names[i]));
+        if (!stat(path, &info))
+            status = copy_file(path, names[i]);
+        else remove(names[i]);
+        free(path);
+    }
+    if (status){
+        print_stored(path = join_path(entry, CACHE_MESSAGES), status_output());
+        free(path);
+        print_stored(path = join_path(entry, CACHE_ERRORS), error_output());
+        free(path);
+        if (output_buffer_read_file(&contents, path = join_path(entry, CACHE_LINES))){
+            output_buffer_append_char(&contents, '\0');
+            *lines = atoi(contents.text);
+            output_buffer_free(&contents);
+        }
+        free(path);
+        utimensat(AT_FDCWD, entry, NULL, 0);
+    }
+    count_use(status ? &statistics.hits : &statistics.misses, 1);
+    free(entry);
+    return status;
+}
+
+/*
+ * output_cache_store:
+ * stores the entry "key" holding the "count" output files named in "names"
+ * which exist, the number of "lines" of their source, and the "messages_length"
+ * characters of "messages" and the "errors_length" characters of "errors"
+ * printed while they were assembled.
+ * if the entry can't be stored, or another one was stored with the same key
+ * meanwhile, the cache is left as it was.
+ */
+void output_cache_store(const char *key, char **names, int count, int lines, const char *messages,
+        size_t messages_length, const char *errors, size_t errors_length){
+    struct stat info;
+    char *temp, *entry, *path, number[24];
+    int i, status;
+    if (!cache_directory)
+        return;
+    temp = join_path(cache_directory, CACHE_TEMP_PREFIX "XXXXXX");
+    if (!mkdtemp(temp)){
+        free(temp);
+        return;
+    }
+    path = join_path(temp, CACHE_MESSAGES);
+    status = store_text(path, messages, messages_length);
+    free(path);
+    if (status){
+        path = join_path(temp, CACHE_ERRORS);
+        status = store_text(path, errors, errors_length);
+        free(path);
+    }
+    if (status){
+        path = join_path(temp, CACHE_LINES);
+        sprintf(number, "%d\n", lines);
+        status = store_text(path, number, strlen(number));
+        free(path);
+    }
+    for (i = 0; i < count && status; i++){
+        path = join_path(temp, extension_of(names[i]));
+        if (!stat(names[i], &info))
+            status = copy_file(names[i], path);
+        free(path);
+    }
+    entry = join_path(cache_directory, key);
+    if (status && !rename(temp, entry))
+        count_use(&statistics.stores, 1);
+    else remove_entry(temp);
+    free(entry);
+    free(temp);
+}
+
+/*
+ * cached_entry:
+ * an entry of the cache as "trim_output_cache" sees it: its "name", its
+ * "size" in bytes and the time it was last used ("used").
+ */
+typedef struct cached_entry {
+    char *name;
+    long size;
+    time_t used;
+} cached_entry;
+
+/*
+ * compare_use:
+ * orders two entries by the time they were last used, for "qsort".
+ */
+static int compare_use(const void *first, const void *second){
+    time_t a = ((const cached_entry*)first)->used, b = ((const cached_entry*)second)->used;
+    return (a > b) - (a < b);
+}
+
+/*
+ * entry_size:
+ * returns the number of bytes the files of the entry directory "path" hold.
+ */
+static long entry_size(const char *path){
+    DIR *directory = opendir(path);
+    struct dirent *item;
+    struct stat info;
+    long size = 0;
+    char *file;
+    if (!directory)
+        return 0;
+    while ((item = readdir(directory))){
+        file = join_path(path, item->d_name);
+        if (!stat(file, &info) && S_ISREG(info.st_mode))
+            size += info.st_size;
+        free(file);
+    }
+    closedir(directory);
+    return size;
+}
+
+/*
+ * temp_entry:
+ * checks whether the entry named "name" is a temporary one, still being
+ * stored or left by a store which never completed. returns 1 if so, 0
+ * otherwise.
+ */
+static int temp_entry(const char *name){
+    return !strncmp(name, CACHE_TEMP_PREFIX, strlen(CACHE_TEMP_PREFIX));
+}
+
+/*
+ * trim_output_cache:
+ * removes the entries of the cache which were used least recently, until
+ * the size of the rest is within the cache's limit. temporary entries are
+ * not counted, and the ones older than CACHE_TEMP_AGE seconds, which were
+ * left by a program which stopped while storing them, are removed.
+ */
+void trim_output_cache(void){
+    DIR *directory;
+    struct dirent *item;
+    struct stat info;
+    cached_entry *entries = NULL, *temp;
+    int count = 0, capacity = 0, i;
+    long total = 0;
+    if (!cache_directory || !(directory = opendir(cache_directory)))
+        return;
+    while ((item = readdir(directory))){
+        char *path;
+        if (item->d_name[0] == '.')
+            continue;
+        path = join_path(cache_directory, item->d_name);
+        if (stat(path, &info) || !S_ISDIR(info.st_mode)){
+            free(path);
+            continue;
+        }
+        if (temp_entry(item->d_name)){
+            if (difftime(time(NULL), info.st_mtime) > CACHE_TEMP_AGE)
+                remove_entry(path);
+            free(path);
+            continue;
+        }
+        if (count == capacity){
+            capacity = capacity ? 2 * capacity : INITIAL_OUTPUT_CAPACITY;
+            if (!(temp = (cached_entry*)realloc(entries, capacity * sizeof(cached_entry))))
+                exit_program_fatal_error();
+            entries = temp;
+        }
+        entries[count].name = path;
+        entries[count].size = entry_size(path);
+        entries[count].used = info.st_mtime;
+        total += entries[count++].size;
+    }
+    closedir(directory);
+    qsort(entries, count, sizeof(cached_entry), compare_use);
+    for (i = 0; i < count; i++){
+        if (total > cache_limit){
+            total -= entries[i].size;
+            remove_entry(entries[i].name);
+            count_use(&statistics.evicted, 1);
+        }
+        free(entries[i].name);
+    }
+    free(entries);
+}
+
+/*
+ * get_output_cache_statistics:
+ * returns the counts of the cache's use so far.
+ */
+cache_statistics get_output_cache_statistics(void){
+    cache_statistics counts;
+    pthread_mutex_lock(&statistics_lock);
+    counts = statistics;
+    pthread_mutex_unlock(&statistics_lock);
+    return counts;
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#ifndef OUTPUT_CACHE_H
+#define OUTPUT_CACHE_H
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include "output_buffer.h"
+    #include "output_backend.h"
+
+    /*the number of characters of a cache key, including the terminating '\0'*/
+    #define OUTPUT_KEY_SIZE 17
+    /*the default size the cache is trimmed to, in megabytes*/
+    #define CACHE_DEFAULT_LIMIT 256
+    /*
+     * identifies the assembler's outputs for the cache: it should be changed
+     * whenever a change to the assembler changes the files it produces, so
+     * entries stored by an older version are not used.
+     */
+    #define CACHE_VERSION "assembler-2"
+    /*the names of the files an entry keeps the messages of its assembly in*/
+    #define CACHE_MESSAGES "messages"
+    #define CACHE_ERRORS "errors"
+    /*the name of the file an entry keeps the number of lines of its source in*/
+    #define CACHE_LINES "lines"
+    /*the prefix of the names of the entries being stored*/
+    #define CACHE_TEMP_PREFIX "tmp."
+    /*the age in seconds after which an entry still being stored is considered left by a crash*/
+    #define CACHE_TEMP_AGE 3600
+
+    /*
+     * the counts of the cache's use since the program started: the assemblies
+     * found in the cache ("hits") and not found ("misses"), the entries stored
+     * ("stores") and the entries removed to keep the cache's size ("evicted").
+     */
+    typedef struct cache_statistics {
+        int hits;
+        int misses;
+        int stores;
+        int evicted;
+    } cache_statistics;
+
+    void set_output_cache(char*);
+    void set_output_cache_limit(long);
+    int output_cache_enabled(void);
+    void hash_source_key(const char*, const char*, size_t, char*);
+    void output_cache_key(const char*, size_t, int, char*);
+    int output_cache_restore(const char*, char**, int, int*);
+    void output_cache_store(const char*, char**, int, int, const char*, size_t, const char*, size_t);
+    void trim_output_cache(void);
+    cache_statistics get_output_cache_statistics(void);
+
+#endif
\ No newline at end of file
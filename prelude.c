@@ -0,0 +1,189 @@
+#define _POSIX_C_SOURCE 200809L
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "prelude.h"
+#include "assembler.h"
+
+/*
+ * This module handles preludes: sources of ".extern" declarations which many
+ * files share, like the declarations a precompiled header holds. a prelude is
+ * assembled once, by "make_prelude", into a snapshot of its symbols, a compact
+ * binary file in the layout of the structs in the header. a snapshot is loaded
+ * once, by "load_prelude", which maps it to memory and builds its symbols into
+ * a table in a single pass (all the nodes in one allocation), which the symbol
+ * table then looks symbols up in for every file (see "set_prelude_table"), as
+ * if the prelude's declarations were at the beginning of the file, without
+ * parsing or inserting them again for each file. the key of the loaded snapshot
+ * is part of the keys of the output cache and the IR files, since the outputs
+ * depend on it. the example "Prelude_Input_1.as" uses the externs declared by
+ * "Prelude.as" without declaring them, and is kept with its output files when
+ * assembled with its snapshot.
+ */
+
+/*"prelude_key": the hash of the loaded snapshot, empty if none was loaded*/
+static char prelude_key[OUTPUT_KEY_SIZE] = "";
+
+/*
+ * only_declarations:
+ * checks that the source processed by the first pass in "context" only
+ * declared external symbols: it has no words, no entries and no labels of
+ * any other kind. returns 1 if so, 0 otherwise.
+ */
+static int only_declarations(assembler_context *context){
+    hash_table *table = context->symbol_table;
+    node *curr;
+    int i;
+    if (get_ic(context) || get_dc(context) || context->second_pass.entries_list->head)
+        return 0;
+    for (i = 0; i < table->array_size; i++)
+        for (curr = table->array[i]->head; curr; curr = curr->next)
+            if (curr->type != EXTERN)
+                return 0;
+    return 1;
+}
+
+/*
+ * build_snapshot:
+ * initializes "file" with the snapshot of the symbols of the symbol table
+ * in "context".
+ */
+static void build_snapshot(assembler_context *context, output_buffer *file){
+    hash_table *table = context->symbol_table;
+    prelude_header header;
+    prelude_symbol item;
+    node *curr;
+    int i;
+    memset(&header, 0, sizeof(prelude_header));
+    memcpy(header.magic, PRELUDE_MAGIC, PRELUDE_MAGIC_SIZE);
+    output_buffer_init(file, 0);
+    output_buffer_append(file, (char*)&header, sizeof(prelude_header));
+    for (i = 0; i < table->array_size; i++)
+        for (curr = table->array[i]->head; curr; curr = curr->next, header.count++){
+            memset(&item, 0, sizeof(prelude_symbol));
+            strcpy(item.key, curr->key);
+            item.type = curr->type;
+            item.address = ((label*)curr->data)->address.value;
+            output_buffer_append(file, (char*)&item, sizeof(prelude_symbol));
+        }
+    memcpy(file->text, &header, sizeof(prelude_header));
+}
+
+/*
+ * make_prelude:
+ * assembles the prelude "filename" (without the ".as" extension) into the
+ * snapshot file of the same name with the ".pre" extension. a prelude may
+ * only hold ".extern" declarations (and comments), otherwise an error is
+ * printed. returns 1 if the snapshot was written, 0 otherwise.
+ */
+int make_prelude(char *filename){
+    assembler_context *context = current_context();
+    char *source = add_extension(filename, ".as"), *snapshot = add_extension(filename, PRELUDE_EXTENSION);
+    output_buffer file;
+    int status = 0;
+    begin_resource_usage();
+    if (load_input_file(context, source)){
+        initialize_symbol_table(context);
+        initialize_memory(context);
+        initialize_second_pass_lists(context);
+        if (first_pass_process(context)){
+            if (only_declarations(context)){
+                build_snapshot(context, &file);
+                status = output_buffer_write_file(&file, snapshot);
+                output_buffer_free(&file);
+            }
+            else fprintf(stderr, "Error: the prelude \"%s\" may only hold \".extern\" declarations.\n", source);
+        }
+        free_symbol_table(context);
+        free_memory(context);
+        free_second_pass_lists(context);
+        close_input_file(context);
+    }
+    else fprintf(stderr, "Error: unable to open file \"%s\".\n", source);
+    free(source);
+    free(snapshot);
+    return status;
+}
+
+/*
+ * valid_snapshot:
+ * checks whether the "length" characters of "text" are a snapshot file of
+ * external symbols with valid names. returns 1 if so, 0 otherwise.
+ */
+static int valid_snapshot(const char *text, size_t length){
+    const prelude_header *header = (const prelude_header*)text;
+    const prelude_symbol *symbols = (const prelude_symbol*)(text + sizeof(prelude_header));
+    int i;
+    if (length < sizeof(prelude_header) || memcmp(header->magic, PRELUDE_MAGIC, PRELUDE_MAGIC_SIZE) || header->count < 0
+            || length != sizeof(prelude_header) + header->count * sizeof(prelude_symbol))
+        return 0;
+    for (i = 0; i < header->count; i++)
+        if (!memchr(symbols[i].key, '\0', MAX_NAME_SIZE) || symbols[i].type != EXTERN)
+            return 0;
+    return 1;
+}
+
+/*
+ * restore_snapshot:
+ * builds the symbols of the snapshot file "text", which should be valid, into
+ * a new table, which becomes the symbol table's prelude. the table's array is
+ * sized by the number of symbols, and the nodes and their labels are allocated
+ * together and never freed, like the builtin table.
+ */
+static void restore_snapshot(const char *text){
+    const prelude_header *header = (const prelude_header*)text;
+    const prelude_symbol *symbols = (const prelude_symbol*)(text + sizeof(prelude_header));
+    hash_table *table = hash_table_construct(DEFAULT_SIZE + header->count, default_hash_function);
+    node *nodes = (node*)calloc(header->count + 1, sizeof(node));
+    label *labels = (label*)calloc(header->count + 1, sizeof(label));
+    int i;
+    if (!nodes || !labels)
+        exit_program_fatal_error();
+    for (i = 0; i < header->count; i++){
+        strcpy(nodes[i].key, symbols[i].key);
+        nodes[i].type = symbols[i].type;
+        labels[i].address.value = symbols[i].address;
+        nodes[i].data = labels + i;
+        linked_list_insert(table->array[table->function(nodes[i].key, table->array_size)], nodes + i);
+    }
+    set_prelude_table(table);
+}
+
+/*
+ * load_prelude:
+ * maps the snapshot file named "path" to memory and loads its symbols as the
+ * prelude of every file assembled from now on. should be called before any
+ * file is assembled. if the file can't be opened or is not a valid snapshot,
+ * an error is printed. returns 1 if the prelude was loaded, 0 otherwise.
+ */
+int load_prelude(char *path){
+    struct stat info;
+    char *text;
+    int fd = open(path, O_RDONLY), status = 0;
+    if (fd < 0){
+        fprintf(stderr, "Error: unable to open file \"%s\".\n", path);
+        return 0;
+    }
+    if (!fstat(fd, &info) && info.st_size >= (off_t)sizeof(prelude_header)
+            && (text = (char*)mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) != MAP_FAILED){
+        if ((status = valid_snapshot(text, info.st_size))){
+            restore_snapshot(text);
+            hash_source_key(PRELUDE_MAGIC "\n", text, info.st_size, prelude_key);
+        }
+        munmap(text, info.st_size);
+    }
+    close(fd);
+    if (!status)
+        fprintf(stderr, "Error: \"%s\" is not a valid prelude snapshot.\n", path);
+    return status;
+}
+
+/*
+ * get_prelude_key:
+ * returns the key of the loaded prelude snapshot, an empty string if none
+ * was loaded.
+ */
+const char *get_prelude_key(void){
+    return prelude_key;
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef PRELUDE_H
+#define PRELUDE_H
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include "assembler_context.h"
+    #include "output_cache.h"
+
+    /*the extension of a prelude's snapshot file*/
+    #define PRELUDE_EXTENSION ".pre"
+    /*the characters a snapshot file starts with, including the terminating '\0'*/
+    #define PRELUDE_MAGIC "ASMPRE1"
+    #define PRELUDE_MAGIC_SIZE 8
+
+    /*the beginning of a snapshot file: the number of symbols which follow it*/
+    typedef struct prelude_header {
+        char magic[PRELUDE_MAGIC_SIZE];
+        int count;
+    } prelude_header;
+
+    /*a symbol of a prelude as a snapshot file holds it: its name, type and address*/
+    typedef struct prelude_symbol {
+        char key[MAX_NAME_SIZE];
+        int type;
+        int address;
+    } prelude_symbol;
+
+    int make_prelude(char*);
+    int load_prelude(char*);
+    const char *get_prelude_key(void);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "relocation.h"
+#include "assembler.h"
+
+/*
+ * This module implements the relocation table of an assembled program, and
+ * moving the program to another base address without assembling it again.
+ * the base C is added to every address the assembler writes: the addresses of
+ * the ".ob" file's lines, the ".ent" and ".ext" files' addresses, and the
+ * instruction words holding data addresses (including structs). the first
+ * three are found by their position in the files, and the last are listed in
+ * the relocation table, the ".rel" file, so rebasing a program only adds the
+ * difference between the bases to each of these, and never decodes the
+ * instructions or looks up a symbol. since only the address bits that fit a
+ * word are kept, the difference is added in the same bits, and the result is
+ * the same as assembling the program with the new base. the examples' correct
+ * inputs are kept with their relocation tables, and in "Examples/Rebased_150"
+ * with their files moved to the base 150, which move back to the same files
+ * with the base 100.
+ */
+
+/*
+ * add_relocation:
+ * appends a line with "index" in the "awkward base" to the relocation "table".
+ */
+void add_relocation(output_buffer *table, int index){
+    output_buffer_append_word(table, index);
+    output_buffer_append_char(table, '\n');
+}
+
+/*
+ * save_relocations_to_file:
+ * creates the relocation table file named "filename": a line with C followed
+ * by the lines of "table", which are built by "add_relocation" during the
+ * second pass. returns 1 on success, otherwise an error is reported and 0 is
+ * returned.
+ */
+int save_relocations_to_file(char *filename, output_buffer *table){
+    output_buffer output;
+    int status;
+    output_buffer_init(&output, RELOCATION_LINE_SIZE + table->length);
+    add_relocation(&output, C);
+    output_buffer_append(&output, table->text, table->length);
+    status = output_buffer_write_file(&output, filename);
+    output_buffer_free(&output);
+    return status;
+}
+
+/*
+ * rebase_object:
+ * moves the ".ob" file in "object" from the base address "old_base" to "base":
+ * the address of each line is replaced, and the words at the indexes listed in
+ * the relocation table "relocations" (following its first line) are moved by
+ * the difference between the bases. returns 1 on success, or 0 if either file
+ * is not in the expected format or the program does not fit below the largest
+ * address at the new base.
+ */
+static int rebase_object(output_buffer *object, output_buffer *relocations, int old_base, int base){
+    char *text = object->text;
+    size_t position;
+    int ic, dc, i;
+    if (object->length < OBJECT_HEADER_SIZE || (object->length - OBJECT_HEADER_SIZE) % AWKWARD_LINE_SIZE
+            || (ic = decode_awkward_word(text)) < 0 || text[AWKWARD_WORD_SIZE] != '\t'
+            || (dc = decode_awkward_word(text + AWKWARD_WORD_SIZE + 1)) < 0
+            || (object->length - OBJECT_HEADER_SIZE) / AWKWARD_LINE_SIZE != (size_t)(ic + dc)
+            || base + ic + dc > AWKWARD_VALUES)
+        return 0;
+    for (i = 0; i < ic + dc; i++){
+        char *line = text + OBJECT_HEADER_SIZE + i * AWKWARD_LINE_SIZE;
+        if (line[0] != '\n' || decode_awkward_word(line + 1) != ((old_base + i) & (AWKWARD_VALUES - 1))
+                || line[AWKWARD_WORD_SIZE + 1] != '\t')
+            return 0;
+    }
+    for (position = RELOCATION_LINE_SIZE; position < relocations->length; position += RELOCATION_LINE_SIZE){
+        int index = decode_awkward_word(relocations->text + position);
+        char *target;
+        int value;
+        if (index < 0 || index >= ic || relocations->text[position + AWKWARD_WORD_SIZE] != '\n')
+            return 0;
+        target = text + OBJECT_HEADER_SIZE + index * AWKWARD_LINE_SIZE + AWKWARD_WORD_SIZE + 2;
+        if ((value = decode_awkward_word(target)) < 0)
+            return 0;
+        encode_awkward_word(value + ((base - old_base) << 2), target);
+    }
+    for (i = 0; i < ic + dc; i++)
+        encode_awkward_word(base + i, text + OBJECT_HEADER_SIZE + i * AWKWARD_LINE_SIZE + 1);
+    return 1;
+}
+
+/*
+ * rebase_symbols:
+ * adds "difference" to the address of each line of the ".ent" or ".ext" file
+ * in "symbols", whose lines hold a symbol's name, a space and its address in
+ * the "awkward base". returns 1 on success, or 0 if the file is not in the
+ * expected format.
+ */
+static int rebase_symbols(output_buffer *symbols, int difference){
+    char *text = symbols->text;
+    size_t position = 0;
+    while (position < symbols->length){
+        char *space = memchr(text + position, ' ', symbols->length - position);
+        int address;
+        if (!space || (size_t)(space - text) + RELOCATION_LINE_SIZE >= symbols->length
+                || space[RELOCATION_LINE_SIZE] != '\n' || (address = decode_awkward_word(space + 1)) < 0)
+            return 0;
+        encode_awkward_word(address + difference, space + 1);
+        position = space - text + RELOCATION_LINE_SIZE + 1;
+    }
+    return 1;
+}
+
+/*
+ * rebase_file:
+ * moves the assembled program "name" (a file name without an extension) to
+ * the base address "base", using its relocation table: its ".ob", ".ent",
+ * ".ext" and ".rel" files are replaced by the ones assembling it with that
+ * base would produce. a missing ".ent" or ".ext" file has no symbols. returns
+ * 1 on success, otherwise an error is printed and 0 is returned.
+ */
+int rebase_file(char *name, int base){
+    char *ob_name = add_extension(name, ".ob"), *ent_name = add_extension(name, ".ent");
+    char *ext_name = add_extension(name, ".ext"), *rel_name = add_extension(name, RELOCATION_EXTENSION);
+    output_buffer object, entries, externs, relocations;
+    int has_object = output_buffer_read_file(&object, ob_name);
+    int has_entries = output_buffer_read_file(&entries, ent_name);
+    int has_externs = output_buffer_read_file(&externs, ext_name);
+    int has_relocations = output_buffer_read_file(&relocations, rel_name);
+    int old_base = -1, status = 0;
+    if (has_relocations && relocations.length >= RELOCATION_LINE_SIZE && !(relocations.length % RELOCATION_LINE_SIZE)
+            && relocations.text[AWKWARD_WORD_SIZE] == '\n')
+        old_base = decode_awkward_word(relocations.text);
+    if (!has_object)
+        fprintf(stderr, "Error: unable to open file \"%s\".\n", ob_name);
+    else if (!has_relocations)
+        fprintf(stderr, "Error: unable to open file \"%s\".\n", rel_name);
+    else if (old_base < 0)
+        fprintf(stderr, "Error: \"%s\" is not a valid relocation table file.\n", rel_name);
+    else if (!rebase_object(&object, &relocations, old_base, base))
+        fprintf(stderr, "Error: \"%s\" cannot be moved to the address %d.\n", ob_name, base);
+    else if (!rebase_symbols(&entries, base - old_base))
+        fprintf(stderr, "Error: \"%s\" is not a valid entries file.\n", ent_name);
+    else if (!rebase_symbols(&externs, base - old_base))
+        fprintf(stderr, "Error: \"%s\" is not a valid externs file.\n", ext_name);
+    else {
+        encode_awkward_word(base, relocations.text);
+        status = output_buffer_write_file(&object, ob_name)
+                && (!has_entries || output_buffer_write_file(&entries, ent_name))
+                && (!has_externs || output_buffer_write_file(&externs, ext_name))
+                && output_buffer_write_file(&relocations, rel_name);
+    }
+    output_buffer_free(&object);
+    output_buffer_free(&entries);
+    output_buffer_free(&externs);
+    output_buffer_free(&relocations);
+    free(ob_name);
+    free(ent_name);
+    free(ext_name);
+    free(rel_name);
+    return status;
+}
\ No newline at end of file
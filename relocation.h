@@ -0,0 +1,24 @@
+#ifndef RELOCATION_H
+#define RELOCATION_H
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include "word.h"
+    #include "output_buffer.h"
+    #include "memory_manager.h"
+
+    /*
+     * the relocation table file layout: a line with the base address the files
+     * were assembled for, then a line with the index of each instruction word
+     * holding a data address, all in the "awkward base".
+     */
+    #define RELOCATION_LINE_SIZE (AWKWARD_WORD_SIZE + 1)
+    /*the extension of relocation table files*/
+    #define RELOCATION_EXTENSION ".rel"
+
+    void add_relocation(output_buffer*, int);
+    int save_relocations_to_file(char*, output_buffer*);
+    int rebase_file(char*, int);
+
+#endif
\ No newline at end of file
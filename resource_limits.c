@@ -0,0 +1,167 @@
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#include "assembler_context.h"
+
+/*
+ * This module holds each file to the limits set on the command line, so a
+ * single pathological file (an enormous one, or one with millions of labels)
+ * can't hold the program, or a batch worker, for long or take all of its
+ * memory. the limits are on the time a file takes, its number of lines and
+ * symbols, and the memory its growing state takes: its contents, its symbols,
+ * its entries and externs lists and its fixups (the memory arrays and the
+ * output files are bounded by the memory size anyway). they are checked by the
+ * first pass and by the allocators of that state, against the usage kept in
+ * the current context, and the time is also checked while the second pass
+ * resolves the fixups, and before the output files are written or restored. a file which goes over a limit is reported with an error
+ * and abandoned like after a fatal error (see "abandon_file"), so the next file
+ * is still assembled.
+ */
+
+/*
+ * "limits": the limits every file is held to, set once before any file is
+ * processed. "limited" indicates whether any limit is set, so files without
+ * limits are not slowed down by the checks. "limits_key" describes the limits
+ * for the output cache, since a file's outputs depend on them.
+ */
+static resource_limits limits;
+static int limited = 0;
+static char limits_key[LIMITS_KEY_SIZE] = "";
+
+/*
+ * current_seconds:
+ * returns the time in seconds from some fixed point, for measuring durations.
+ */
+static double current_seconds(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/*
+ * exceed_limit:
+ * reports that the file being processed went over its limit of "amount"
+ * "resource", and abandons it.
+ */
+static void exceed_limit(const char *resource, const char *amount){
+    assembler_context *context = current_context();
+    int line = context->first_pass.line_count;
+    char text[DIAGNOSTIC_SIZE];
+    if (line)
+        sprintf(text, "Error, line %d: the file is over its %s limit (%s), stopped processing the file!", line, resource, amount);
+    else sprintf(text, "Error: the file is over its %s limit (%s), stopped processing the file!", resource, amount);
+    context->usage.exceeded = 1;
+    report_diagnostic(line, 0, 0, text);
+    abandon_file();
+}
+
+/*
+ * exceed_count_limit:
+ * like "exceed_limit" for a limit of "count" items.
+ */
+static void exceed_count_limit(const char *resource, long count){
+    char amount[32];
+    sprintf(amount, "%ld", count);
+    exceed_limit(resource, amount);
+}
+
+/*
+ * set_resource_limits:
+ * holds every file processed from now on to "new_limits". should be called
+ * before any file is processed.
+ */
+void set_resource_limits(const resource_limits *new_limits){
+    limits = *new_limits;
+    limited = limits.seconds > 0 || limits.lines > 0 || limits.symbols > 0 || limits.bytes > 0;
+    if (limited)
+        sprintf(limits_key, "%g %ld %ld %ld", limits.seconds, limits.lines, limits.symbols, limits.bytes);
+    else limits_key[0] = '\0';
+}
+
+/*
+ * get_limits_key:
+ * returns the text describing the limits set, an empty string if none is.
+ */
+const char *get_limits_key(void){
+    return limits_key;
+}
+
+/*
+ * begin_resource_usage:
+ * starts measuring the usage of the file about to be processed in the current
+ * context. should be called before its contents are loaded.
+ */
+void begin_resource_usage(void){
+    resource_usage *usage = &current_context()->usage;
+    usage->started = limits.seconds > 0 ? current_seconds() : 0;
+    usage->symbols = 0;
+    usage->bytes = 0;
+    usage->exceeded = 0;
+}
+
+/*
+ * check_line_limits:
+ * checks the number of lines the first pass is held to, once it reached the
+ * line "line_count".
+ */
+void check_line_limits(int line_count){
+    if (limits.lines > 0 && line_count > limits.lines)
+        exceed_count_limit("lines", limits.lines);
+}
+
+/*
+ * check_time_limit:
+ * checks the time the file took so far against its limit.
+ */
+void check_time_limit(void){
+    char amount[32];
+    if (limits.seconds > 0 && current_seconds() - current_context()->usage.started > limits.seconds){
+        sprintf(amount, "%g seconds", limits.seconds);
+        exceed_limit("time", amount);
+    }
+}
+
+/*
+ * next_time_check:
+ * returns the position in an input of "length" characters, read up to
+ * "position", at which the time should be checked next: TIME_CHECK_CHARACTERS
+ * further, so a single long line is checked as well, or the input's end if
+ * the time is not limited.
+ */
+size_t next_time_check(size_t position, size_t length){
+    if (limits.seconds <= 0 || length - position <= TIME_CHECK_CHARACTERS)
+        return length;
+    return position + TIME_CHECK_CHARACTERS;
+}
+
+/*
+ * count_symbol:
+ * counts a symbol about to be inserted to the file's symbol table.
+ */
+void count_symbol(void){
+    if (limits.symbols > 0 && ++current_context()->usage.symbols > limits.symbols)
+        exceed_count_limit("symbols", limits.symbols);
+}
+
+/*
+ * within_memory_limit:
+ * returns 1 if allocating "bytes" more would keep the file within its memory
+ * limit, 0 otherwise, without counting them.
+ */
+int within_memory_limit(size_t bytes){
+    return limits.bytes <= 0 || current_context()->usage.bytes + (long)bytes <= limits.bytes;
+}
+
+/*
+ * count_allocation:
+ * counts "bytes" about to be allocated for the file's state.
+ */
+void count_allocation(size_t bytes){
+    char amount[32];
+    if (limits.bytes <= 0)
+        return;
+    if (!within_memory_limit(bytes)){
+        sprintf(amount, "%ld MB", limits.bytes / (1024L * 1024L));
+        exceed_limit("memory", amount);
+    }
+    current_context()->usage.bytes += bytes;
+}
\ No newline at end of file
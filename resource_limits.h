@@ -0,0 +1,51 @@
+#ifndef RESOURCE_LIMITS_H
+#define RESOURCE_LIMITS_H
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+
+    /*the number of fixups the second pass resolves between checks of the time a file takes*/
+    #define TIME_CHECK_INTERVAL 64
+    /*the number of characters the first pass reads between checks of the time a file takes*/
+    #define TIME_CHECK_CHARACTERS 65536
+    /*the size of the text describing the limits, for the output cache's keys*/
+    #define LIMITS_KEY_SIZE 96
+
+    /*
+     * the limits each file is held to, 0 for no limit: the wall time it may
+     * take in "seconds", the number of "lines" and of "symbols" (labels and
+     * external symbols) it may have, and the number of "bytes" its growing
+     * state (its contents, its symbols, its lists and fixups) may take.
+     */
+    typedef struct resource_limits {
+        double seconds;
+        long lines;
+        long symbols;
+        long bytes;
+    } resource_limits;
+
+    /*
+     * what the file being processed used so far, of the limited resources: the
+     * time it was "started" in seconds from some fixed point, the number of
+     * "symbols" inserted and the number of "bytes" allocated. "exceeded" is set
+     * once it went over one of the limits.
+     */
+    typedef struct resource_usage {
+        double started;
+        long symbols;
+        long bytes;
+        int exceeded;
+    } resource_usage;
+
+    void set_resource_limits(const resource_limits*);
+    void begin_resource_usage(void);
+    void check_line_limits(int);
+    void check_time_limit(void);
+    size_t next_time_check(size_t, size_t);
+    const char *get_limits_key(void);
+    void count_symbol(void);
+    int within_memory_limit(size_t);
+    void count_allocation(size_t);
+
+#endif
\ No newline at end of file
@@ -1,4 +1,4 @@
-#include "second_pass_processor.h"
+#include "assembler_context.h"
 
 /*
  * the objects and data structures in the file should be created and
@@ -24,34 +24,31 @@
  * of "ABSOLUTE" type in an instruction. this list is traversed and each of its nodes
  * is checked to contain a key which represents an EXTERN variable, if so, the symbol
  * and the address of the symbol in the instructions array is written to the ".ext"
- * file. a separate list is used instead of the "second_pass_list" for convenience
+ * file. a separate list is used instead of the "fixups" array for convenience
  * purposes only, so the list can be manipulated (e.g. reversed) without the risk of
- * corrupting of the "second_pass_list" (second_pass_list and externs_list contain
- * different kinds of information and are not identical) and accessing the relevant
- * address more easily.
+ * corrupting of the "fixups" array ("fixups" and externs_list contain different
+ * kinds of information and are not identical) and accessing the relevant address
+ * more easily.
  */
  
-/*
- * "second_pass_list": is a linked list which contains references to all occurrences
- * of "ABSOLUTE" type operands in instructions and additional data these occurrences.
- * "entries_list": a linked list that contains information about each occurrence of
- * the ".entry" directive in the file.
- * "externs_list": a linked list that contains information about each occurrence of
- * an "ABSOLUTE" type operand for the ".ext" file creation process.
- */ 
-static linked_list *second_pass_list = NULL;
-static linked_list *entries_list = NULL;
-static linked_list *externs_list = NULL;
-
 /*
  * initialize_second_pass_lists:
- * constructs 3 empty linked lists and assigns them to the file's static
- * lined lists. should be called before beginning new file processing.
+ * allocates the "fixups" array and constructs 2 empty linked lists and assigns
+ * them to the file's static lined lists. should be called before beginning new
+ * file processing.
  */
-void initialize_second_pass_lists(void){
-    second_pass_list = linked_list_construct();
-    entries_list = linked_list_construct();
-    externs_list = linked_list_construct();
+void initialize_second_pass_lists(assembler_context *context){
+    count_allocation(INITIAL_FIXUPS_CAPACITY * sizeof(fixup));
+    context->second_pass.fixups = (fixup*)malloc(INITIAL_FIXUPS_CAPACITY * sizeof(fixup));
+    if (!context->second_pass.fixups)
+        exit_program_fatal_error();
+    context->second_pass.fixups_count = 0;
+    context->second_pass.fixups_capacity = INITIAL_FIXUPS_CAPACITY;
+    context->second_pass.entries_list = linked_list_construct();
+    context->second_pass.externs_list = linked_list_construct();
+    output_buffer_init(&context->second_pass.entries_table, 0);
+    output_buffer_init(&context->second_pass.externs_table, 0);
+    output_buffer_init(&context->second_pass.relocations_table, 0);
 }
 
 
@@ -61,40 +58,47 @@ void initialize_second_pass_lists(void){
  * for the next file processing. should be called when current file processing
  * is finished.
  */
-void free_second_pass_lists(void){
-    free_linked_list(second_pass_list);
-    free_linked_list(entries_list);
-    free_linked_list(externs_list);
-    second_pass_list = NULL;
-    entries_list = NULL;
-    externs_list = NULL;
+void free_second_pass_lists(assembler_context *context){
+    free(context->second_pass.fixups);
+    free_linked_list(context->second_pass.entries_list);
+    free_linked_list(context->second_pass.externs_list);
+    output_buffer_free(&context->second_pass.entries_table);
+    output_buffer_free(&context->second_pass.externs_table);
+    output_buffer_free(&context->second_pass.relocations_table);
+    context->second_pass.fixups = NULL;
+    context->second_pass.fixups_count = 0;
+    context->second_pass.fixups_capacity = 0;
+    context->second_pass.entries_list = NULL;
+    context->second_pass.externs_list = NULL;
 }
 
 /*
  * spl_insert:
- * inserts a new node into "second_pass_list". "line_data" type contains
- * information which will be used for error checking, mainly to check if
- * what appears as a ".struct" operand indeed refers to a ".struct" data type.
- * the function creates a new "node" with its key field set to "key" and
- * "type" to 0 (since it wont be used). it also creates a new "line_data"
- * to store the flag "is_struct" and "line_count" (for error reporting).
- * the "line_data" is assigned to the new node's "data" field after being
- * cast to void pointer. the new node's "index" field is set to "inst_index",
- * which refers to the operands word index in the instruction array (in the
- * memory manager). returns a node to the newly constructed node.
+ * appends a new "fixup" to the end of the "fixups" array, doubling the array's
+ * size when it's full. the fixup stores the symbol "key", "inst_index", which
+ * refers to the operands word index in the instruction array (in the memory
+ * manager), "line_count" (for error reporting) and the flag "is_struct", which
+ * is used to check if what appears as a ".struct" operand indeed refers to a
+ * ".struct" data type. returns a pointer to the new fixup, which is valid until
+ * the next insertion. the array's growth counts against the file's memory limit.
  */
-node *spl_insert(char *key, int inst_index, int line_count, int is_struct){
-    node *new_node = node_construct(key, 0);
-    line_data *data = (line_data*)malloc(sizeof(line_data));
-    if (data){
-        new_node->index = inst_index;
-        data->line_count = line_count;
-        data->is_struct = is_struct;
-        new_node->data = (void*)data;
-        linked_list_insert(second_pass_list, new_node);
-        return new_node;
+fixup *spl_insert(assembler_context *context, char *key, int inst_index, int line_count, int is_struct){
+    fixup *item;
+    if (context->second_pass.fixups_count == context->second_pass.fixups_capacity){
+        fixup *temp;
+        count_allocation(context->second_pass.fixups_capacity * sizeof(fixup));
+        temp = (fixup*)realloc(context->second_pass.fixups, 2 * context->second_pass.fixups_capacity * sizeof(fixup));
+        if (!temp)
+            return exit_program_fatal_error();
+        context->second_pass.fixups = temp;
+        context->second_pass.fixups_capacity *= 2;
     }
-    else return exit_program_fatal_error();
+    item = context->second_pass.fixups + context->second_pass.fixups_count++;
+    strcpy(item->key, key);
+    item->inst_index = inst_index;
+    item->line_count = line_count;
+    item->is_struct = is_struct;
+    return item;
 }
 
 /*
@@ -103,14 +107,17 @@ node *spl_insert(char *key, int inst_index, int line_count, int is_struct){
  * list, 0 for externs list), where the key is "symbol" and "counter" as the
  * node's "index" field, which has different meaning, depending on the item
  * and list being added. a pointer to the newly constructed node is returned.
+ * the node counts against the file's memory limit.
  */
-node *ent_ext_list_insert(char *symbol, int is_ent, int counter){
-    node *new_node = node_construct(symbol, 0);
+node *ent_ext_list_insert(assembler_context *context, char *symbol, int is_ent, int counter){
+    node *new_node;
+    count_allocation(sizeof(node));
+    new_node = node_construct(symbol, 0);
     if (new_node) new_node->index = counter;
     if(is_ent)
-        linked_list_insert(entries_list, new_node);
+        linked_list_insert(context->second_pass.entries_list, new_node);
     else    {
-        linked_list_insert(externs_list, new_node);
+        linked_list_insert(context->second_pass.externs_list, new_node);
     }        
     return new_node;    
 }
@@ -120,8 +127,8 @@ node *ent_ext_list_insert(char *symbol, int is_ent, int counter){
  * looks for "symbol" in the entries list and returns a pointer to
  * the node if exists or NULL otherwise.
  */
-node *entries_list_find(char *symbol){
-    return linked_list_find(entries_list, symbol);
+node *entries_list_find(assembler_context *context, char *symbol){
+    return linked_list_find(context->second_pass.entries_list, symbol);
 }
 
 /*
@@ -135,46 +142,47 @@ static int extract_address(node *symbol){
 
 /*
  * print_second_pass_error:
- * a wrapper for "print_second_pass_error" defined in the "error_handler" file.
- * it takes "node" instead, of an integer representing line count, and extracts
- * and extracts the "line_count" field from its "date field", after casting it
- * to "line_data" type. also sets the status pointer passed to 0 to indicate
- * to the calling function that there was an error.
+ * a wrapper for "print_error_string" defined in the "error_handler" file.
+ * it takes a "fixup" instead, of an integer representing line count, and
+ * extracts its "line_count" field. also sets the status pointer passed to 0
+ * to indicate to the calling function that there was an error.
  */
-static void print_second_pass_error(int *status, node *curr, int error){
+static void print_second_pass_error(int *status, fixup *curr, int error){
     *status = 0;
-    print_error_string(((line_data*)(curr->data))->line_count, error, curr->key);
+    print_error_string(curr->line_count, error, curr->key);
 }
 
 /*
  * second_pass_struct:
  * used to process an operand entered as a struct and stored in the 
- * "second_pass_list" as such. the function checks if the "symbol" found
+ * "fixups" array as such. the function checks if the "symbol" found
  * indeed belongs to a struct (not any other kind of data, register, command..)
  * if not so, an error is printed, otherwise the address of the symbol is
  * extracted and stored in the right place in the instruction array.
  */
-static void second_pass_struct(node *curr, node *symbol, int *status){
+static void second_pass_struct(assembler_context *context, fixup *curr, node *symbol, int *status){
     if (symbol->type == DATA && ((label*)(symbol->data))->is_struct == 1){
-        int address = C + get_ic() + extract_address(symbol);
-        instructions_array_set_index(curr->index , ((address<<2) + 2));
+        int address = C + get_ic(context) + extract_address(symbol);
+        instructions_array_set_index(context, curr->inst_index , ((address<<2) + 2));
+        add_relocation(&context->second_pass.relocations_table, curr->inst_index);
     }
     else print_second_pass_error(status, curr, 28);
 }
 
 /*
  * second_pass_process:
- * this function traverses the "second_pass_list" and checks if the symbol
- * ("key)" stored in each node contains a valid label present in the symbols
- * table. if the symbol does not exist, an error is printed.
- * if a symbol exists: if the "curr" node refers to a .struct, "second_pass_struct"
+ * this function goes through the "fixups" array in order and checks if the
+ * symbol ("key)" stored in each fixup contains a valid label present in the
+ * symbols table. if the symbol does not exist, an error is printed.
+ * if a symbol exists: if the "curr" fixup refers to a .struct, "second_pass_struct"
  * is called to process it, otherwise, if the symbol type is "EXTERN",
  * the address (00-000000-01) is extracted and stored in the data array in the
  * original IC index when the operand was processed. if it's of type "DATA" (either
  * .data or .string) the index is extracted from the symbol (the one found in the
  * symbols table) in addition to starting index (C : 100) and the last IC (the total
  * is the final address of the variable in the data array) and this value is set
- * in the instructions array of the memory manager. the address is shifted two
+ * in the instructions array of the memory manager, and the word is added to the
+ * relocation table since it depends on C. the address is shifted two
  * bits to the left to add the A,R,E encoding which is supposed to be equal to
  * 10 (2 in decimal). if a symbol was found and it's not of the former two types,
  * then it must be either a command, directive or register so a proper error
@@ -183,26 +191,27 @@ static void second_pass_struct(node *curr, node *symbol, int *status){
  * the integer returned indicates if any errors occurred to the caller.
  * this function will not be called in case first pass has failed.
  */
-int second_pass_process(void){
+int second_pass_process(assembler_context *context){
     int status = 1;
-    node *symbol, *curr;
-    reverse_list(second_pass_list);
-    curr = (second_pass_list != NULL) ? second_pass_list->head : NULL;
-    while(curr){
-        if ((symbol = find_symbol(curr->key))){
-            if (((line_data*)(curr->data))->is_struct == 1) second_pass_struct(curr, symbol, &status);
+    node *symbol;
+    fixup *curr, *end = context->second_pass.fixups + context->second_pass.fixups_count;
+    for (curr = context->second_pass.fixups; curr < end; curr++){
+        if (!((curr - context->second_pass.fixups) % TIME_CHECK_INTERVAL))
+            check_time_limit();
+        if ((symbol = find_symbol(context, curr->key))){
+            if (curr->is_struct == 1) second_pass_struct(context, curr, symbol, &status);
             else if (symbol->type == EXTERN)
-                instructions_array_set_index(curr->index , extract_address(symbol));
+                instructions_array_set_index(context, curr->inst_index , extract_address(symbol));
             else if (symbol->type == DATA){
-                int address = C + get_ic() + extract_address(symbol);
-                instructions_array_set_index(curr->index , ((address<<2) + 2));
+                int address = C + get_ic(context) + extract_address(symbol);
+                instructions_array_set_index(context, curr->inst_index , ((address<<2) + 2));
+                add_relocation(&context->second_pass.relocations_table, curr->inst_index);
             }
             else print_second_pass_error(&status, curr, 27);
         }
         else print_second_pass_error(&status, curr, 26);
-        curr = curr->next;
     }
-    printf("\nSecond pass status: %s\n", status ? "Success" : "Failure");
+    fprintf(status_output(), "\nSecond pass status: %s\n", status ? "Success" : "Failure");
     return status;
 }
 
@@ -219,87 +228,138 @@ static void print_entries_file_error(int *status, node *curr, int error){
 }
 
 /*
- * create_entries_file:
- * "filename" is the name of the file this function creates to save the entries
- * data. the function creates a new file, reverses the entries list so it appears
+ * append_symbol:
+ * appends the line of the symbol "key" at "address" to the ".ent" or ".ext"
+ * file being built in "file", in the selected output format, and its record
+ * to "table".
+ */
+static void append_symbol(output_buffer *file, output_buffer *table, char *key, int address){
+    get_output_backend()->append_symbol(file, key, address);
+    binary_symbols_append(table, key, address);
+}
+
+/*
+ * build_entries:
+ * initializes "entries_file" with the contents of the entries file: the function
+ * reverses the entries list so it appears
  * in the original order (as items appear in the source file), the list is then 
  * traversed and each node is checked: if a symbol with same key does not exist
  * in the symbols table, an error is printed, if a symbol exists, this symbol is checked
  * if it contains a label of either "DATA" or "INST_L" (a label which appears before
  * an instruction), if so, the symbol is printed along with its address (IC is added
  * in case the label is in the data section), if the symbol represents any other
- * type, an error is printed. "lines_count" is incremented each time a line is actually
- * written to the file, if it's equal to 0 or any errors occurred (status is 0),
- * the file is removed. the processing stops only when the list is exhausted, and
- * keeps going on even if errors have been detected.
+ * type, an error is printed. if any errors occurred, the buffer is emptied and 0
+ * is returned, otherwise 1. the processing stops only when the
+ * list is exhausted, and keeps going on even if errors have been detected.
  * there might be situations were an ".ob" file is created while an error prevented
  * the assembler from creating ".ent" file: in this case the ".ob" file is not removed,
  * but is notified that errors have occurred trying to create the entries file, so the
  * user decides what to do.
  */
-void create_entries_file(char *filename){
-    int status = 1, lines_count =0;
-    FILE *entries_file = fopen(filename, "w");
+int build_entries(assembler_context *context, output_buffer *entries_file){
+    int status = 1;
     node *symbol, *curr;
-    reverse_list(entries_list);
-    curr = entries_list->head;    
-    if (entries_list){
-        while(curr){
-            symbol = find_symbol(curr->key);
-            if (symbol) {
-                char temp_str[MAX_NAME_SIZE];
-                if (symbol->type == DATA) fprintf(entries_file, "%s %s\n", curr->key, convert_int_to_awkward_base(C + get_ic() + extract_address(symbol), temp_str));
-                else if (symbol->type == INST_L) fprintf(entries_file, "%s %s\n", curr->key, convert_int_to_awkward_base(C + extract_address(symbol), temp_str));
-                else print_entries_file_error(&status, curr, 30);
-                if (status) lines_count++;
-            }
-            else print_entries_file_error(&status, curr, 29);
-            curr = curr->next;
+    reverse_list(context->second_pass.entries_list);
+    curr = context->second_pass.entries_list->head;    
+    output_buffer_init(entries_file, 0);
+    while(curr){
+        symbol = find_symbol(context, curr->key);
+        if (symbol) {
+            if (symbol->type == DATA) append_symbol(entries_file, &context->second_pass.entries_table, curr->key, C + get_ic(context) + extract_address(symbol));
+            else if (symbol->type == INST_L) append_symbol(entries_file, &context->second_pass.entries_table, curr->key, C + extract_address(symbol));
+            else print_entries_file_error(&status, curr, 30);
         }
-        fclose(entries_file);
-        if (!status || !lines_count) remove(filename);        
+        else print_entries_file_error(&status, curr, 29);
+        curr = curr->next;
+    }
+    if (!status){
+        entries_file->length = 0;
+        context->second_pass.entries_table.length = 0;
     }
-    else fprintf(stderr, "Error: unable to create the file \"%s\".\n", filename);
+    return status;
 }
 
 /*
- * create_externs_files:
+ * create_entries_file:
  * "filename" is the name of the file this function creates to save the entries
- * data. the function creates a new file, reverses the externs list so it appears
+ * data, built by "build_entries". if there are no entries or any errors occurred,
+ * no file is written (and an existing one is removed).
+ */
+void create_entries_file(assembler_context *context, char *filename){
+    output_buffer entries_file;
+    if (build_entries(context, &entries_file) && entries_file.length)
+        output_buffer_write_file(&entries_file, filename);
+    else remove(filename);
+    output_buffer_free(&entries_file);
+}
+
+/*
+ * build_externs:
+ * initializes "externs_file" with the contents of the externs file: the function
+ * reverses the externs list so it appears
  * in the original order (as items appear in the source file), the list is then 
  * traversed and each node is checked: if a symbol with same key does not exist
  * in the symbols table, nothing happens, since such an error would have been
  * already detected by "second_pass_process", if a symbol exists, this symbol 
  * is checked if it contains a label of "EXTERN" type, which was declared using
  * ".extern" directive, the address of the operand in the instructions array
- * (plus L) is printed to the file and "lines_count" is incremented. it is worth
+ * (plus L) is added to the buffer. it is worth
  * noting that first pass processing wont let and extern variable's name
  * collude with another variable or symbol name, so this algorithm is correct,
  * and ensures all occurrences of each extern variable in the instructions section
  * is properly recorded and stored in the ".ext" file, in case no other errors
  * have occurred.
- * if no lines were written to the file, it is removed.
  */
-void create_externs_files(char *filename){
-    int lines_count = 0;
+void build_externs(assembler_context *context, output_buffer *externs_file){
     node *symbol, *curr;
-    FILE *externs_file = fopen(filename, "w");
-    reverse_list(externs_list);
-    curr = externs_list->head;
-    if (externs_file){
-        while(curr){
-            symbol = find_symbol(curr->key);
-            if (symbol) {
-                char temp_str[MAX_NAME_SIZE];
-                if (symbol->type == EXTERN){
-                    fprintf(externs_file, "%s %s\n", curr->key, convert_int_to_awkward_base(C + curr->index , temp_str));
-                    lines_count++;
-                }
-            }        
-            curr = curr->next;
-        }
-        fclose(externs_file);
-        if (!lines_count) remove(filename);
+    reverse_list(context->second_pass.externs_list);
+    curr = context->second_pass.externs_list->head;
+    output_buffer_init(externs_file, 0);
+    while(curr){
+        symbol = find_symbol(context, curr->key);
+        if (symbol && symbol->type == EXTERN)
+            append_symbol(externs_file, &context->second_pass.externs_table, curr->key, C + curr->index);
+        curr = curr->next;
     }
-    else fprintf(stderr, "Error: unable to create the file \"%s\".\n", filename);
+}
+
+/*
+ * create_externs_files:
+ * "filename" is the name of the file this function creates to save the externs
+ * data, built by "build_externs". if no lines were found, no file is written
+ * (and an existing one is removed).
+ */
+void create_externs_files(assembler_context *context, char *filename){
+    output_buffer externs_file;
+    build_externs(context, &externs_file);
+    if (externs_file.length) output_buffer_write_file(&externs_file, filename);
+    else remove(filename);
+    output_buffer_free(&externs_file);
+}
+
+/*
+ * get_entries_table:
+ * returns the records of the symbols written to the ".ent" file, none if the
+ * file was not written. valid after "create_entries_file" is called.
+ */
+output_buffer *get_entries_table(assembler_context *context){
+    return &context->second_pass.entries_table;
+}
+
+/*
+ * get_externs_table:
+ * returns the records of the symbols written to the ".ext" file. valid after
+ * "create_externs_files" is called.
+ */
+output_buffer *get_externs_table(assembler_context *context){
+    return &context->second_pass.externs_table;
+}
+
+/*
+ * get_relocations_table:
+ * returns the relocation table of the current file, complete once the second
+ * pass is done.
+ */
+output_buffer *get_relocations_table(assembler_context *context){
+    return &context->second_pass.relocations_table;
 }
\ No newline at end of file
@@ -7,21 +7,61 @@
     #include "symbol_table.h"
     #include "memory_manager.h"
     #include "error_handler.h"
+    #include "binary_object.h"
+    #include "relocation.h"
 	
-    /* a struct which contains information to be stored in the "data"
-    * field of a "node" that belongs to the "second_pass_list". */	 
-    typedef struct line_data {
-        int line_count : 10;
+    /*the initial number of items allocated for the fixups array, doubled as needed*/
+    #define INITIAL_FIXUPS_CAPACITY 32
+
+    /* a struct which contains information about an "ABSOLUTE" operand that
+    * needs its address set by the second pass: the symbol it refers to, the
+    * index of its word in the instructions array and the line it appears in. */	 
+    typedef struct fixup {
+        char key[MAX_NAME_SIZE];
+        int inst_index;
+        int line_count;
         unsigned int is_struct : 1;
-    } line_data;    
+    } fixup;
+
+    /*
+     * the lists of the file being processed:
+     * "fixups": is an array which contains references to all occurrences of "ABSOLUTE"
+     * type operands in instructions and additional data about these occurrences, in
+     * the order they were found in the file. "fixups_count" is the number of items
+     * stored and "fixups_capacity" the number of items allocated.
+     * "entries_list": a linked list that contains information about each occurrence of
+     * the ".entry" directive in the file.
+     * "externs_list": a linked list that contains information about each occurrence of
+     * an "ABSOLUTE" type operand for the ".ext" file creation process.
+     * "entries_table" and "externs_table": the records of the symbols written to
+     * the ".ent" and ".ext" files, in the binary object format, for the binary
+     * object file.
+     * "relocations_table": the lines of the relocation table (see the "relocation"
+     * module), the index of each instruction word holding a data address.
+     */
+    typedef struct second_pass_state {
+        fixup *fixups;
+        int fixups_count;
+        int fixups_capacity;
+        linked_list *entries_list;
+        linked_list *externs_list;
+        output_buffer entries_table;
+        output_buffer externs_table;
+        output_buffer relocations_table;
+    } second_pass_state;
     
-    void initialize_second_pass_lists(void);
-    void free_second_pass_lists(void);
-    node *ent_ext_list_insert(char*, int, int);
-    node *entries_list_find(char*);
-    int second_pass_process(void);
-    void create_entries_file(char*);
-    void create_externs_files(char*);
-    node *spl_insert(char*, int, int, int);
+    void initialize_second_pass_lists(assembler_context*);
+    void free_second_pass_lists(assembler_context*);
+    node *ent_ext_list_insert(assembler_context*, char*, int, int);
+    node *entries_list_find(assembler_context*, char*);
+    int second_pass_process(assembler_context*);
+    int build_entries(assembler_context*, output_buffer*);
+    void create_entries_file(assembler_context*, char*);
+    void build_externs(assembler_context*, output_buffer*);
+    void create_externs_files(assembler_context*, char*);
+    fixup *spl_insert(assembler_context*, char*, int, int, int);
+    output_buffer *get_entries_table(assembler_context*);
+    output_buffer *get_externs_table(assembler_context*);
+    output_buffer *get_relocations_table(assembler_context*);
             
 #endif
\ No newline at end of file
@@ -0,0 +1,255 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <signal.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "server.h"
+
+/*
+ * This module runs the assembler as a server, listening on a UNIX domain
+ * socket, so programs which assemble many small sources (like editors) don't
+ * start the program for each one, and the builtin tables and caches are kept
+ * from one request to the next. several threads accept connections at the
+ * same time, each serving the requests of its connection one after the other,
+ * with an assembler context of its own. a request is one of:
+ * "SOURCE length\n" followed by the "length" characters of a source, which is
+ * assembled in memory (see "assemble_source"), or "PATH name\n", which assembles
+ * the file "name" (without the ".as" extension) as the command line does,
+ * writing its output files next to it. both are answered by "STATUS status\n"
+ * (see "assembly_status"), followed by the sections "OBJECT", "ENTRIES",
+ * "EXTERNS", "MESSAGES" and "ERRORS", each written as "NAME length\n" followed by
+ * "length" characters (the first three are empty for a "PATH" request). a
+ * request which can't be read is answered by "STATUS 3\n" alone, and the
+ * connection is closed. the server runs until it's interrupted or terminated.
+ * since a "PATH" request reads and writes files with the server's permissions,
+ * the socket is created with access for the server's user only. with an output
+ * cache, the cache is trimmed after every SERVER_TRIM_INTERVAL "PATH" requests.
+ */
+
+/*
+ * "listener": the socket connections are accepted on, bound to "address".
+ * "server_outputs": the extra files "PATH" requests produce (see "assemble_file").
+ * "paths_since_trim": the number of "PATH" requests served since the output
+ * cache was last trimmed, guarded by "trim_lock".
+ */
+static int listener = -1;
+static struct sockaddr_un address;
+static int server_outputs = 0;
+static int paths_since_trim = 0;
+static pthread_mutex_t trim_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * stop_server:
+ * the handler of the signals which stop the server: removes the socket's file
+ * and ends the program.
+ */
+static void stop_server(int signal_number){
+    (void)signal_number;
+    unlink(address.sun_path);
+    _exit(EXIT_SUCCESS);
+}
+
+/*
+ * write_section:
+ * writes the section "name" of an answer to "out", with the "length"
+ * characters of "text".
+ */
+static void write_section(FILE *out, const char *name, const char *text, size_t length){
+    fprintf(out, "%s %lu\n", name, (unsigned long)length);
+    fwrite(text, 1, length, out);
+}
+
+/*
+ * answer:
+ * writes the answer holding "result" to "out", returns 1 if it was written, 0
+ * otherwise (the client is gone).
+ */
+static int answer(FILE *out, assembly_result *result){
+    fprintf(out, "STATUS %d\n", result->status);
+    write_section(out, "OBJECT", result->object.text, result->object.length);
+    write_section(out, "ENTRIES", result->entries.text, result->entries.length);
+    write_section(out, "EXTERNS", result->externs.text, result->externs.length);
+    write_section(out, "MESSAGES", result->messages.text, result->messages.length);
+    write_section(out, "ERRORS", result->errors.text, result->errors.length);
+    return !fflush(out) && !ferror(out);
+}
+
+/*
+ * trim_when_due:
+ * counts a "PATH" request served, and trims the output cache once every
+ * SERVER_TRIM_INTERVAL of them, since the server never ends like a run of
+ * the command line, after which the cache is trimmed.
+ */
+static void trim_when_due(void){
+    int due;
+    pthread_mutex_lock(&trim_lock);
+    if ((due = (++paths_since_trim >= SERVER_TRIM_INTERVAL)))
+        paths_since_trim = 0;
+    pthread_mutex_unlock(&trim_lock);
+    if (due)
+        trim_output_cache();
+}
+
+/*
+ * assemble_path:
+ * assembles the file named "name" (without the ".as" extension) as the command
+ * line does, capturing its messages and diagnostics in "result", which should
+ * be freed by "free_assembly_result". if the messages can't be captured, the
+ * file is not assembled and the status is "ASSEMBLY_OUT_OF_MEMORY".
+ */
+static void assemble_path(char *name, assembly_result *result){
+    assembler_context context;
+    char *out_text = NULL, *err_text = NULL;
+    size_t out_length = 0, err_length = 0;
+    memset(result, 0, sizeof(assembly_result));
+    initialize_context(&context);
+    context.out = open_memstream(&out_text, &out_length);
+    context.err = open_memstream(&err_text, &err_length);
+    if (!context.out || !context.err){
+        if (context.out)
+            fclose(context.out);
+        if (context.err)
+            fclose(context.err);
+        free(out_text);
+        free(err_text);
+        result->status = ASSEMBLY_OUT_OF_MEMORY;
+        return;
+    }
+    context.diagnostics = &result->diagnostics;
+    set_current_context(&context);
+    result->status = assemble_file(name, server_outputs) ? ASSEMBLY_SUCCESS : ASSEMBLY_ERRORS;
+    set_current_context(NULL);
+    sync_output_directories();
+    fclose(context.out);
+    fclose(context.err);
+    result->messages.text = out_text;
+    result->messages.length = result->messages.capacity = out_length;
+    result->errors.text = err_text;
+    result->errors.length = result->errors.capacity = err_length;
+}
+
+/*
+ * serve_request:
+ * reads a request from "in", assembles it and writes the answer to "out".
+ * returns 1 if the connection can be used for another request, 0 if it has
+ * ended or the request could not be read.
+ */
+static int serve_request(FILE *in, FILE *out){
+    char line[SERVER_LINE_SIZE], *source;
+    long length;
+    assembly_result result;
+    int status;
+    if (!fgets(line, SERVER_LINE_SIZE, in))
+        return 0;
+    line[strcspn(line, "\r\n")] = '\0';
+    if (sscanf(line, "SOURCE %ld", &length) == 1 && length >= 0 && length <= MAX_SOURCE_SIZE
+            && (source = (char*)malloc(length + 1))){
+        if (fread(source, 1, length, in) != (size_t)length){
+            free(source);
+            return 0;
+        }
+        assemble_source(source, length, &result);
+        free(source);
+    }
+    else if (!strncmp(line, "PATH ", 5) && line[5]){
+        assemble_path(line + 5, &result);
+        trim_when_due();
+    }
+    else {
+        fprintf(out, "STATUS %d\n", BAD_REQUEST);
+        fflush(out);
+        return 0;
+    }
+    status = answer(out, &result);
+    free_assembly_result(&result);
+    return status;
+}
+
+/*
+ * serve_connections:
+ * the function each of the server's threads runs: accepts a connection and
+ * serves its requests until it ends, then accepts the next one.
+ */
+static void *serve_connections(void *unused){
+    int connection;
+    FILE *in, *out;
+    while ((connection = accept(listener, NULL, NULL)) >= 0 || errno == EINTR || errno == ECONNABORTED){
+        if (connection < 0)
+            continue;
+        in = fdopen(connection, "r");
+        out = fdopen(dup(connection), "w");
+        if (in && out)
+            while (serve_request(in, out))
+                ;
+        if (in) fclose(in);
+        else close(connection);
+        if (out) fclose(out);
+    }
+    return unused;
+}
+
+/*
+ * open_listener:
+ * creates the socket named "path" and starts listening on it, replacing a
+ * socket left by a server which was not stopped properly. the socket is made
+ * accessible to the server's user only (SOCKET_MODE) before it starts
+ * listening. returns 1 if so, 0 otherwise (an error is printed).
+ */
+static int open_listener(char *path){
+    struct stat info;
+    if (strlen(path) >= sizeof(address.sun_path)){
+        fprintf(stderr, "Error: the socket name \"%s\" is too long.\n", path);
+        return 0;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    if (!stat(path, &info) && S_ISSOCK(info.st_mode))
+        unlink(path);
+    if ((listener = socket(AF_UNIX, SOCK_STREAM, 0)) < 0
+            || bind(listener, (struct sockaddr*)&address, sizeof(address))
+            || chmod(path, SOCKET_MODE) || listen(listener, SERVER_BACKLOG)){
+        fprintf(stderr, "Error: unable to listen on the socket \"%s\".\n", path);
+        if (listener >= 0)
+            close(listener);
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * run_server:
+ * listens on the socket named "path" and serves the requests of its clients
+ * by "workers" threads (including the calling one), "PATH" requests produce
+ * the extra "outputs" (see "assemble_file"). returns 0 only if the server could
+ * not be started, or stopped accepting connections.
+ */
+int run_server(char *path, int workers, int outputs){
+    pthread_t *threads;
+    int started;
+    if (!open_listener(path))
+        return 0;
+    server_outputs = outputs;
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, stop_server);
+    signal(SIGTERM, stop_server);
+    enable_thread_contexts();
+    threads = (pthread_t*)malloc(workers * sizeof(pthread_t));
+    if (!threads)
+        exit_program_fatal_error();
+    printf("Listening on \"%s\"...\n", path);
+    fflush(stdout);
+    for (started = 0; started < workers - 1; started++)
+        if (pthread_create(threads + started, NULL, serve_connections, NULL))
+            break;
+    serve_connections(NULL);
+    while (started > 0)
+        pthread_join(threads[--started], NULL);
+    free(threads);
+    close(listener);
+    unlink(path);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include "assembler.h"
+    #include "job_pool.h"
+
+    /*the number of connections waiting to be accepted the socket holds*/
+    #define SERVER_BACKLOG 64
+    /*the maximum length of a request's header line, including the file's name*/
+    #define SERVER_LINE_SIZE 4096
+    /*the maximum number of characters of a source sent in a request*/
+    #define MAX_SOURCE_SIZE (64L * 1024 * 1024)
+    /*the status answered to a request which could not be read*/
+    #define BAD_REQUEST 3
+    /*the mode of the socket: only the server's user may connect*/
+    #define SOCKET_MODE 0600
+    /*the number of "PATH" requests served between trimmings of the output cache*/
+    #define SERVER_TRIM_INTERVAL 64
+
+    int run_server(char*, int, int);
+
+#endif
\ No newline at end of file
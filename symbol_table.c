@@ -1,4 +1,6 @@
-#include "symbol_table.h"
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#include "assembler_context.h"
 
 /*
  * This module implements a symbol table for the assembler's use: it is 
@@ -6,122 +8,67 @@
  * the assembly process, it contains all the commands, registers, labels,
  * etc.. the nodes might contain different "data" fields depending on their
  * role, some are defined in the header of this file. since the program needs
- * one such table, it's constructed in this module and is accessible only to
- * it. some functions are also static, since they are not needed outside this
+ * one such table for each file, it's kept in the assembler context each of
+ * the functions receives (see "assembler_context") and is accessed only
+ * through this module. some functions are also static, since they are not needed outside this
  * module. the table is initialized when the program starts working on a new file,
  * and should be destroyed when done, the initializer and destructor are called
- * by the user.
+ * by the user. the commands, registers and directives are the same for every
+ * file, so they are kept apart, in a table which is built once and shared by
+ * all the files (and threads), and only the file's own labels are inserted to
+ * its table. the external symbols of a prelude (see the "prelude" module) are
+ * kept apart the same way, in a table loaded once. a symbol is looked up in
+ * all of them.
  */
- 
- /* this is the hash table itself and will only be visible to this file.
-  * it is explicitly initialized to NULL (though static variables are  
-  * implicitly initialized to 0 in C).
-  */
-static hash_table *symbol_table = NULL;
 
 /*
- * construct_instruction:
- * creates a new "instruction" which contains the information relevant to an
- * "instruction" command: its "input" and "output" supported addressing types,
- * and its "word_value" equivalent: 4 bits (there are 16 in total) shifted 6 bits
- * to the left, to allow the addition of the operands addressing type encoding
- * to the instruction word (e.g. "add" will have the value 0010-0000-00). this
- * function returns a pointer to the "instruction", which will be stored in the
- * nodes data feild.
+ * "builtin_table": the commands, registers and directives, never changed once
+ * built by "create_builtin_table", which "builtin_once" makes sure runs once.
  */
-static instruction *construct_instruction(int input, int output, int word_value){
-    word new_word;
-    instruction *data;
-    word_value <<= 6;
-    new_word.value = word_value;
-    data = (instruction*)malloc(sizeof(instruction));
-    if(data){
-        data->input = input;
-        data->output = output;
-        data->value = new_word;
-        return data;
-    }
-    else return exit_program_fatal_error();
-}
+static hash_table *builtin_table = NULL;
+static pthread_once_t builtin_once = PTHREAD_ONCE_INIT;
 
 /*
- * load_instructions:
- * loads the 16 instructions into the symbol_table, and calls "construct_instruction"
- * for each, to create the "instruction" with the proper information. the instruction
- * is casted to void pointer before it's passed to "hash_table_insert". "INST" is
- * defined in the "type" enumeration in the header, and represents the node's symbol type.
+ * "prelude_table": the symbols of the prelude, NULL if there is none, never
+ * changed once set by "set_prelude_table".
  */
-static void load_instructions(void){
-    hash_table_insert(symbol_table, "mov", (void *)construct_instruction(2, 1, 0), INST);
-    hash_table_insert(symbol_table, "cmp", (void *)construct_instruction(2, 2, 1), INST);
-    hash_table_insert(symbol_table, "add", (void *)construct_instruction(2, 1, 2), INST);
-    hash_table_insert(symbol_table, "sub", (void *)construct_instruction(2, 1, 3), INST);
-    hash_table_insert(symbol_table, "not", (void *)construct_instruction(0, 1, 4), INST);
-    hash_table_insert(symbol_table, "clr", (void *)construct_instruction(0, 1, 5), INST);
-    hash_table_insert(symbol_table, "lea", (void *)construct_instruction(1, 1, 6), INST);
-    hash_table_insert(symbol_table, "inc", (void *)construct_instruction(0, 1, 7), INST);
-    hash_table_insert(symbol_table, "dec", (void *)construct_instruction(0, 1, 8), INST);
-    hash_table_insert(symbol_table, "jmp", (void *)construct_instruction(0, 1, 9), INST);
-    hash_table_insert(symbol_table, "bne", (void *)construct_instruction(0, 1, 10), INST);
-    hash_table_insert(symbol_table, "red", (void *)construct_instruction(0, 1, 11), INST);
-    hash_table_insert(symbol_table, "prn", (void *)construct_instruction(0, 2, 12), INST);
-    hash_table_insert(symbol_table, "jsr", (void *)construct_instruction(0, 1, 13), INST);
-    hash_table_insert(symbol_table, "rts", (void *)construct_instruction(0, 0, 14), INST);
-    hash_table_insert(symbol_table, "stop", (void *)construct_instruction(0, 0, 15), INST);
+static hash_table *prelude_table = NULL;
+
+/*
+ * insert_builtin:
+ * inserts a symbol named "name" of type "type" into the builtin table, with
+ * "index" set as the node's index field and no data.
+ */
+static void insert_builtin(const char *name, int type, int index){
+    hash_table_insert(builtin_table, (char*)name, NULL, type);
+    hash_table_find(builtin_table, (char*)name)->index = index;
 }
 
 /*
- * load_psw_register:
- * creates a register named "PSW" and loads it into the symbol table, this is 
- * a private case of the function "load_registers". the register code is the highest
- * possible and is equal to "REGISTERS_COUNT" which is set to 8 by default: so if
- * registers r0-r7 will occupy codes/addresses 0-7, PSW will occupy code 8.
+ * load_instructions:
+ * loads the 16 instructions described in the "isa" module into the builtin table.
+ * "INST" is defined in the "type" enumeration in the header, and represents the
+ * node's symbol type. the node's index is the instruction's opcode, which is all
+ * that's needed to find its description with "isa_instruction_at".
  */
-static void load_psw_register(void){
-    int temp;
-    regs *data;
-    word input, output;
-    char code[4] = "PSW";
-    data = (regs*)malloc(sizeof(regs));
-    temp = REGISTERS_COUNT;
-    input.value = temp<<6;
-    output.value = temp<<2;
-    if (data){
-        data->input_op = input;
-        data->output_op = output;
-        hash_table_insert(symbol_table, code, (void *)data, REGS);
-    }
-    else exit_program_fatal_error();    
+static void load_instructions(void){
+    int i;
+    for (i = 0; i < INSTRUCTIONS_COUNT; i++)
+        insert_builtin(isa_instruction_at(i)->name, INST, i);
 }
 
 /*
  * load_registers:
- * creates "count" "regs" (which represent a register, defined in the file header),
- * and inserts them into the symbol table. each "regs" contains the encoding for
- * when it's an input and an output operand, for example: r1 will have the value
- * 0000-01-00-00 when it's passed as input operand and 0000-00-01-00 for output.
- * "REGS" is defined in the enumeration "type".
- * the function also calls "load_psw_register".
+ * loads the registers described in the "isa" module: r0-r7 and "PSW", into
+ * the builtin table. the node's index is the register's code, from which its
+ * encoding is computed, for example: r1 will have the value 0000-01-00-00 when
+ * it's passed as input operand and 0000-00-01-00 for output. "REGS" is defined
+ * in the enumeration "type".
  */
-static void load_registers(int count){
+static void load_registers(void){
     int i;
-    for (i = 0; i < count; i++){
-        regs *data;
-        char code[3] = "rX";
-        int temp1 = i<<6, temp2 = i<<2;
-        word input, output;
-        code[1] = '0' + i;
-        data = (regs*)malloc(sizeof(regs));
-        input.value = temp1;
-        output.value = temp2;
-        if (data){
-            data->input_op = input;
-            data->output_op = output;
-            hash_table_insert(symbol_table, code, (void *)data, REGS);
-        }
-        else exit_program_fatal_error();
-    }
-    load_psw_register();
+    for (i = 0; i < REGISTERS_TOTAL; i++)
+        insert_builtin(isa_register_at(i)->name, REGS, i);
 }
 
 /*
@@ -144,31 +91,49 @@ static directive *construct_directive(int integers, int string, int label){
 
 /*
  * load_directives:
- * loads the 5 directives keywords into the symbol table using "construct_directive",
+ * loads the 5 directives keywords into the builtin table using "construct_directive",
  * whose result is cast to void pointer, as with "load_instructions". "DIRECT" is
  * defined in the enumeration "type".
  */
 static void load_directives(void){
-    hash_table_insert(symbol_table, ".data", (void *)construct_directive(1, 0, 0), DIRECT);
-    hash_table_insert(symbol_table, ".struct", (void *)construct_directive(1, 1, 0), DIRECT);
-    hash_table_insert(symbol_table, ".string", (void *)construct_directive(0, 1, 0), DIRECT);
-    hash_table_insert(symbol_table, ".entry", (void *)construct_directive(0, 0, 1), DIRECT);
-    hash_table_insert(symbol_table, ".extern", (void *)construct_directive(0, 0, 1), DIRECT);
+    hash_table_insert(builtin_table, ".data", (void *)construct_directive(1, 0, 0), DIRECT);
+    hash_table_insert(builtin_table, ".struct", (void *)construct_directive(1, 1, 0), DIRECT);
+    hash_table_insert(builtin_table, ".string", (void *)construct_directive(0, 1, 0), DIRECT);
+    hash_table_insert(builtin_table, ".entry", (void *)construct_directive(0, 0, 1), DIRECT);
+    hash_table_insert(builtin_table, ".extern", (void *)construct_directive(0, 0, 1), DIRECT);
+}
+
+/*
+ * create_builtin_table:
+ * builds the builtin table with the instructions, registers and directives.
+ */
+static void create_builtin_table(void){
+    builtin_table = hash_table_construct(DEFAULT_SIZE, default_hash_function);
+    load_instructions();
+    load_registers();
+    load_directives();
+}
+
+/*
+ * build_builtin_table:
+ * builds the builtin table, unless it was built already. a process which
+ * forks should call it first, so its children share the table instead of
+ * each building its own.
+ */
+void build_builtin_table(void){
+    pthread_once(&builtin_once, create_builtin_table);
 }
 
 /*
  * initialize_symbol_table:
  * initializes the symbol_table by calling the hash table constructor and storing
- * its return value in "symbol_table". the function then loads the instructions,
- * directives and registers by calling the relevant static functions. this function
+ * its return value in "symbol_table". the instructions, directives and registers
+ * are in the builtin table, which is built the first time only. this function
  * should be called each time a new file needs to be processed by the assembler.
- * by default the are 8 registers "REGISTERS_COUNT".
  */
-void initialize_symbol_table(void){
-    symbol_table = hash_table_construct(DEFAULT_SIZE, default_hash_function);
-    load_instructions();
-    load_registers(REGISTERS_COUNT);
-    load_directives();
+void initialize_symbol_table(assembler_context *context){
+    build_builtin_table();
+    context->symbol_table = hash_table_construct(DEFAULT_SIZE, default_hash_function);
 }
 
 /*
@@ -184,10 +149,15 @@ void initialize_symbol_table(void){
  * "Instructions Counter" is passed for any potential future use. for "DATA" types,
  * the word value is the "Data Counter", which will be extracted later by the file
  * second pass processor. "is_struct" is a flag that marks a ".struct" and will be
- * also used by the second pass processor.
+ * also used by the second pass processor. a symbol which is already present,
+ * as a builtin or a label, is not inserted. each symbol counts against the
+ * file's limits (see "resource_limits").
  */
-void symbol_table_insert_label(char *symbol, int counter, int type, int is_struct){
-    label *data = (label*)malloc(sizeof(label));
+void symbol_table_insert_label(assembler_context *context, char *symbol, int counter, int type, int is_struct){
+    label *data;
+    count_symbol();
+    count_allocation(sizeof(label) + sizeof(node));
+    data = (label*)malloc(sizeof(label));
     if (data){
         word new_word;
         if (type == EXTERN)
@@ -200,26 +170,46 @@ void symbol_table_insert_label(char *symbol, int counter, int type, int is_struc
             data->address = new_word;
             data->is_struct = is_struct;
         }
-        hash_table_insert(symbol_table, symbol, (void *)data, type);        
+        if (hash_table_find(builtin_table, symbol)){
+            fprintf(error_output(), "Error: item is already present: %s\n", symbol);
+            free(data);
+        }
+        else if (!hash_table_insert(context->symbol_table, symbol, (void *)data, type))
+            free(data);
     }
     else exit_program_fatal_error();
 }
 
+/*
+ * set_prelude_table:
+ * sets "table" as the prelude, whose symbols every file sees as if they were
+ * declared at its beginning. should be called before any file is processed.
+ */
+void set_prelude_table(hash_table *table){
+    prelude_table = table;
+}
+
 /*
  * free_symbol_table:
  * frees the symbol_table, by calling the hash_table destructor and sets
  * its value to NULL, in case a new file will be processed "initialize_symbol_table"
  * should be called again. this should be called by the file processing is done.
  */
-void free_symbol_table(void){
-    hash_table_free(symbol_table);
-    symbol_table = NULL;
+void free_symbol_table(assembler_context *context){
+    hash_table_free(context->symbol_table);
+    context->symbol_table = NULL;
 }
 
 /*
  * find_symbol:
- * a wrapper for "hash_table_find", to look for "symbol" in the "symbol_table".
+ * a wrapper for "hash_table_find", to look for "symbol" in the builtin table,
+ * which most lines look up first, then in the "symbol_table", and then in the
+ * prelude, if there is one. a name is never in more than one of them, since
+ * the first pass does not define a symbol which can already be found.
  */
-node *find_symbol(char *symbol){
-    return hash_table_find(symbol_table, symbol);
+node *find_symbol(assembler_context *context, char *symbol){
+    node *found = hash_table_find(builtin_table, symbol);
+    if (!found)
+        found = hash_table_find(context->symbol_table, symbol);
+    return found || !prelude_table ? found : hash_table_find(prelude_table, symbol);
 }
\ No newline at end of file
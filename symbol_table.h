@@ -6,32 +6,21 @@
     #include <string.h>
     #include "word.h"
     #include "hash_table.h"    
+    #include "isa.h"
 
-    #define REGISTERS_COUNT 8
+    /*
+     * the state of the file being assembled, defined in "assembler_context".
+     * the functions of this module, the memory manager and the two passes
+     * receive it as their first parameter.
+     */
+    typedef struct assembler_context assembler_context;
 
-    typedef enum type {INST, REGS, EXTERN, DATA, INST_L, DIRECT} type;
-	
 	/*
-	 * there are 4 types of addressing allowed (immediate, absolute, struct and
-	 * register). for the "input" field: 0 for no input, 1 for types 1-2, and
-	 * 3 for types 0-3. for "output": 0 for no output, 1 for 1-3 and 2 for 0-3.
-	 * the word "value" depends on the context. this should be placed in a node's
-	 * "data" filed. this data type goes with "INST" type.
-	 */	
-    typedef struct instruction {
-        unsigned int input : 2;
-        unsigned int output : 2;
-        word value;
-    } instruction;
- 
- 	/*
-	 * represents a register "REGS" and should be placed in its node "data" 
-	 * field in the symbol table.
-	 */	
-    typedef struct regs {
-        word input_op;
-        word output_op;
-    } regs;
+	 * "INST" and "REGS" nodes have no "data" field: their "index" field holds
+	 * the instruction's opcode or the register's code, which index their
+	 * descriptions in the "isa" module.
+	 */
+    typedef enum type {INST, REGS, EXTERN, DATA, INST_L, DIRECT} type;
     
  	/*
 	 * represents a "DATA", "EXTERN" or "INST_L" label and should be placed 
@@ -53,9 +42,11 @@
         unsigned int label : 1;
     } directive;
     
-    void initialize_symbol_table(void);
-    void symbol_table_insert_label(char*, int, int, int);
-    node *find_symbol(char*);
-    void free_symbol_table(void);
+    void build_builtin_table(void);
+    void initialize_symbol_table(assembler_context*);
+    void symbol_table_insert_label(assembler_context*, char*, int, int, int);
+    node *find_symbol(assembler_context*, char*);
+    void set_prelude_table(hash_table*);
+    void free_symbol_table(assembler_context*);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,211 @@
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+#include "watch.h"
+
+/*
+ * This module assembles the files on the command line, and then keeps
+ * assembling again each one which changes, until the program is interrupted.
+ * the program stays up between rebuilds, so the builtin tables and the caches
+ * are ready and only the changed file is processed. each rebuild is announced
+ * with the time it took. on Linux the directories of the files are watched with
+ * inotify, so a file is assembled as soon as it's saved (directories rather than
+ * the files, since editors often save by replacing the file), elsewhere the
+ * files' change times are checked every WATCH_INTERVAL milliseconds.
+ */
+
+/*
+ * "files" and "files_count": the files being watched.
+ * "watch_outputs": the extra files to produce (see "assemble_file").
+ */
+static watched_file *files = NULL;
+static int files_count = 0;
+static int watch_outputs = 0;
+
+/*
+ * current_seconds:
+ * returns the time in seconds from some fixed point, for measuring durations.
+ */
+static double current_seconds(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/*
+ * change_time:
+ * returns the time the source of "file" was last changed, or -1 if it can't
+ * be found.
+ */
+static double change_time(watched_file *file){
+    struct stat info;
+    char *path = (char*)malloc(strlen(file->name) + 4);
+    int status;
+    if (!path)
+        exit_program_fatal_error();
+    sprintf(path, "%s.as", file->name);
+    status = stat(path, &info);
+    free(path);
+    return status ? -1 : info.st_mtim.tv_sec + info.st_mtim.tv_nsec / 1e9;
+}
+
+/*
+ * assemble_watched:
+ * assembles "file", and prints the time it took, as its first build if
+ * "first" is not 0, or as a rebuild.
+ */
+static void assemble_watched(watched_file *file, int first){
+    double start = current_seconds();
+    int status = assemble_file(file->name, watch_outputs);
+    sync_output_directories();
+    printf("%s \"%s.as\" in %.3f ms%s.\n", first ? "Assembled" : "Reassembled", file->name,
+            1000 * (current_seconds() - start), status ? "" : " (with errors)");
+    fflush(stdout);
+    file->dirty = 0;
+}
+
+/*
+ * rebuild_changed:
+ * assembles each of the files which changed since it was last assembled.
+ */
+static void rebuild_changed(void){
+    int i;
+    for (i = 0; i < files_count; i++)
+        if (files[i].dirty)
+            assemble_watched(files + i, 0);
+}
+
+/*
+ * watch_file:
+ * sets "file" to watch the file named "name" (without the ".as" extension),
+ * splitting it to its directory and its name there.
+ */
+static void watch_file(watched_file *file, char *name){
+    char *slash = strrchr(name, '/');
+    size_t directory_length = slash ? (size_t)(slash - name) + 1 : 1;
+    file->name = name;
+    file->directory = (char*)malloc(directory_length + 1);
+    file->base = (char*)malloc(strlen(slash ? slash + 1 : name) + 4);
+    if (!file->directory || !file->base)
+        exit_program_fatal_error();
+    if (slash){
+        memcpy(file->directory, name, directory_length);
+        file->directory[directory_length] = '\0';
+    }
+    else strcpy(file->directory, ".");
+    sprintf(file->base, "%s.as", slash ? slash + 1 : name);
+    file->watch = -1;
+    file->changed = change_time(file);
+    file->dirty = 0;
+}
+
+/*
+ * poll_changes:
+ * checks the change times of the files every WATCH_INTERVAL milliseconds, and
+ * assembles those which changed. never returns.
+ */
+static void poll_changes(void){
+    struct timespec interval;
+    double changed;
+    int i;
+    interval.tv_sec = WATCH_INTERVAL / 1000;
+    interval.tv_nsec = (WATCH_INTERVAL % 1000) * 1000000L;
+    printf("Watching %d file(s) for changes...\n", files_count);
+    fflush(stdout);
+    for (;;){
+        nanosleep(&interval, NULL);
+        for (i = 0; i < files_count; i++)
+            if ((changed = change_time(files + i)) != files[i].changed){
+                files[i].changed = changed;
+                files[i].dirty = changed >= 0;
+            }
+        rebuild_changed();
+    }
+}
+
+#ifdef __linux__
+/*
+ * mark_changed:
+ * marks the files named by the "length" characters of inotify events in
+ * "events" as changed.
+ */
+static void mark_changed(char *events, ssize_t length){
+    struct inotify_event *event;
+    char *p;
+    int i;
+    for (p = events; p < events + length; p += sizeof(struct inotify_event) + event->len){
+        event = (struct inotify_event*)p;
+        for (i = 0; i < files_count; i++)
+            if (files[i].watch == event->wd && event->len && !strcmp(event->name, files[i].base))
+                files[i].dirty = 1;
+    }
+}
+
+/*
+ * watch_events:
+ * watches the directories of the files with inotify, and assembles each file
+ * once it's written or replaced. the events which arrive together (like those
+ * of a single save) are handled together. returns 0 if inotify could not be
+ * used, and never returns otherwise.
+ */
+static int watch_events(void){
+    union {
+        struct inotify_event event;
+        char text[WATCH_EVENTS_SIZE];
+    } events;
+    struct pollfd pending;
+    ssize_t length;
+    int i;
+    if ((pending.fd = inotify_init()) < 0)
+        return 0;
+    pending.events = POLLIN;
+    for (i = 0; i < files_count; i++)
+        if ((files[i].watch = inotify_add_watch(pending.fd, files[i].directory, IN_CLOSE_WRITE | IN_MOVED_TO)) < 0){
+            close(pending.fd);
+            return 0;
+        }
+    printf("Watching %d file(s) for changes...\n", files_count);
+    fflush(stdout);
+    for (;;){
+        if ((length = read(pending.fd, events.text, WATCH_EVENTS_SIZE)) <= 0){
+            if (length < 0 && errno == EINTR)
+                continue;
+            close(pending.fd);
+            return 0;
+        }
+        mark_changed(events.text, length);
+        while (poll(&pending, 1, 0) > 0 && (length = read(pending.fd, events.text, WATCH_EVENTS_SIZE)) > 0)
+            mark_changed(events.text, length);
+        rebuild_changed();
+    }
+}
+#endif
+
+/*
+ * run_watch:
+ * assembles the "count" files named in "names" (without the ".as" extension)
+ * with the extra "outputs" (see "assemble_file"), then assembles each of them
+ * again whenever it changes. never returns.
+ */
+void run_watch(char **names, int count, int outputs){
+    int i;
+    files = (watched_file*)calloc(count + 1, sizeof(watched_file));
+    if (!files)
+        exit_program_fatal_error();
+    files_count = count;
+    watch_outputs = outputs;
+    for (i = 0; i < count; i++){
+        watch_file(files + i, names[i]);
+        assemble_watched(files + i, 1);
+    }
+#ifdef __linux__
+    watch_events();
+#endif
+    poll_changes();
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include "assembler.h"
+
+    /*the option which selects watch mode*/
+    #define WATCH_OPTION "--watch"
+    /*the time between checks of the files, in milliseconds, where inotify is missing*/
+    #define WATCH_INTERVAL 200
+    /*the size of the buffer inotify events are read into*/
+    #define WATCH_EVENTS_SIZE 4096
+
+    /*
+     * a file assembled in watch mode: its "name" (without the ".as" extension),
+     * the directory it's in ("directory") and its name there with the extension
+     * ("base"), the inotify watch of the directory ("watch"), the time it was last
+     * changed ("changed"), and whether it changed since it was last assembled
+     * ("dirty").
+     */
+    typedef struct watched_file {
+        char *name;
+        char *directory;
+        char *base;
+        int watch;
+        double changed;
+        int dirty;
+    } watched_file;
+
+    void run_watch(char**, int, int);
+
+#endif
\ No newline at end of file
@@ -9,20 +9,112 @@
  * that translate words to the "awkward base".
  */
 
-/*this array, visible to this file only, contains the characters encoding in the "awkward base".*/
-static const char encoding[] = {'!','@','#','$','%','^','&','*','<','>','a','b','c','d','e', 'f',
-                                'g','h','i','j','k','l','m','n','o','p','q','r','s','t','u','v'};
+/*
+ * the characters encoding 5 bits in the "awkward base", in order. "AWKWARD_ROW"
+ * lists the 32 pairs whose first character is "first", and "AWKWARD_TABLE" lists
+ * the rows for every first character, so the pairs of all the 1024 possible 10 bit
+ * values are generated at compile time, in order, as a list of characters (a string
+ * literal that long is more than a C89 compiler has to accept).
+ */
+#define AWKWARD_DIGITS(X) X('!') X('@') X('#') X('$') X('%') X('^') X('&') X('*') \
+                          X('<') X('>') X('a') X('b') X('c') X('d') X('e') X('f') \
+                          X('g') X('h') X('i') X('j') X('k') X('l') X('m') X('n') \
+                          X('o') X('p') X('q') X('r') X('s') X('t') X('u') X('v')
+#define AWKWARD_ROW(first) first, '!', first, '@', first, '#', first, '$', first, '%', first, '^', \
+                           first, '&', first, '*', first, '<', first, '>', first, 'a', first, 'b', \
+                           first, 'c', first, 'd', first, 'e', first, 'f', first, 'g', first, 'h', \
+                           first, 'i', first, 'j', first, 'k', first, 'l', first, 'm', first, 'n', \
+                           first, 'o', first, 'p', first, 'q', first, 'r', first, 's', first, 't', \
+                           first, 'u', first, 'v',
+#define AWKWARD_TABLE {AWKWARD_DIGITS(AWKWARD_ROW)}
+
+/*
+ * this array, visible to this file only, contains the "awkward base" encoding of
+ * each 10 bit value: the 2 characters of value "v" are at indexes 2v and 2v+1.
+ */
+static const char awkward_pairs[2 * AWKWARD_VALUES] = AWKWARD_TABLE;
+
+/*
+ * the value of the "awkward base" character "c", or -1 if "c" is not one of
+ * them. "AWKWARD_DIGIT_VALUES" lists it for 16 consecutive characters, so the
+ * reverse table below is generated at compile time as well.
+ */
+#define AWKWARD_DIGIT_VALUE(c) ((c) >= 'a' && (c) <= 'v' ? (c) - 'a' + 10 : \
+    (c) == '!' ? 0 : (c) == '@' ? 1 : (c) == '#' ? 2 : (c) == '$' ? 3 : (c) == '%' ? 4 : \
+    (c) == '^' ? 5 : (c) == '&' ? 6 : (c) == '*' ? 7 : (c) == '<' ? 8 : (c) == '>' ? 9 : -1)
+#define AWKWARD_DIGIT_VALUES(c) \
+    AWKWARD_DIGIT_VALUE(c), AWKWARD_DIGIT_VALUE(c + 1), AWKWARD_DIGIT_VALUE(c + 2), \
+    AWKWARD_DIGIT_VALUE(c + 3), AWKWARD_DIGIT_VALUE(c + 4), AWKWARD_DIGIT_VALUE(c + 5), \
+    AWKWARD_DIGIT_VALUE(c + 6), AWKWARD_DIGIT_VALUE(c + 7), AWKWARD_DIGIT_VALUE(c + 8), \
+    AWKWARD_DIGIT_VALUE(c + 9), AWKWARD_DIGIT_VALUE(c + 10), AWKWARD_DIGIT_VALUE(c + 11), \
+    AWKWARD_DIGIT_VALUE(c + 12), AWKWARD_DIGIT_VALUE(c + 13), AWKWARD_DIGIT_VALUE(c + 14), \
+    AWKWARD_DIGIT_VALUE(c + 15)
+
+/*
+ * this array, visible to this file only, contains the value of each character in
+ * the "awkward base", indexed by the character's code, and -1 for any other character.
+ */
+static const signed char awkward_digits[256] = {
+    AWKWARD_DIGIT_VALUES(0), AWKWARD_DIGIT_VALUES(16), AWKWARD_DIGIT_VALUES(32),
+    AWKWARD_DIGIT_VALUES(48), AWKWARD_DIGIT_VALUES(64), AWKWARD_DIGIT_VALUES(80),
+    AWKWARD_DIGIT_VALUES(96), AWKWARD_DIGIT_VALUES(112), AWKWARD_DIGIT_VALUES(128),
+    AWKWARD_DIGIT_VALUES(144), AWKWARD_DIGIT_VALUES(160), AWKWARD_DIGIT_VALUES(176),
+    AWKWARD_DIGIT_VALUES(192), AWKWARD_DIGIT_VALUES(208), AWKWARD_DIGIT_VALUES(224),
+    AWKWARD_DIGIT_VALUES(240)
+};
+
+/*
+ * encode_awkward_word:
+ * writes the 2 characters encoding the first 10 bits of "value" in the "awkward
+ * base" to "target", without a terminating null character.
+ */
+void encode_awkward_word(int value, char *target){
+    const char *pair = awkward_pairs + 2 * (value & (AWKWARD_VALUES - 1));
+    target[0] = pair[0];
+    target[1] = pair[1];
+}
+
+/*
+ * decode_awkward_word:
+ * returns the 10 bits value (0 to 1023) encoded by the 2 "awkward base"
+ * characters at "text", or -1 if either of them is not an "awkward base"
+ * character.
+ */
+int decode_awkward_word(const char *text){
+    int high = awkward_digits[(unsigned char)text[0]];
+    int low = awkward_digits[(unsigned char)text[1]];
+    return (high < 0 || low < 0) ? -1 : (high << 5) | low;
+}
+
+/*
+ * encode_object_lines:
+ * writes the object file lines of the "count" words in "words" to "target":
+ * each line is a new line character, the word's address in the "awkward base"
+ * (starting at "first_address"), a tab and the word itself in the "awkward base".
+ * "target" must have room for "count" times AWKWARD_LINE_SIZE characters, no null
+ * character is added. returns a pointer past the last character written.
+ */
+char *encode_object_lines(char *target, const word *words, int count, int first_address){
+    int i;
+    for (i = 0; i < count; i++){
+        target[0] = '\n';
+        encode_awkward_word(first_address + i, target + 1);
+        target[3] = '\t';
+        encode_awkward_word(words[i].value, target + 4);
+        target += AWKWARD_LINE_SIZE;
+    }
+    return target;
+}
 
 /*
  * convert_to_awkward_base:
  * receives a word and a target string: converts the 10 bits integer to its
- * "awkward base" by converting each 5 bits to the corresponding character and
+ * "awkward base" by looking up the pair of characters encoding it, and
  * stores them in the target string. assumes the target string is at least
  * 3 characters wide.
  */
 char* convert_to_awkward_base(word value, char *target){
-    target[0] = encoding[(value.value&992)>>5]; /*992 in binary is 11111-00000 */
-    target[1] = encoding[value.value&31]; /*31 in binary is 00000-11111*/
+    encode_awkward_word(value.value, target);
     target[2] = '\0';
     return target;
 }
@@ -8,7 +8,17 @@
     typedef struct word {
         int value : 10;
     } word;
+
+    /*the number of values a word can hold*/
+    #define AWKWARD_VALUES 1024
+    /*the number of characters a word takes in the "awkward base"*/
+    #define AWKWARD_WORD_SIZE 2
+    /*the characters in an object file line: 2 words, a tab and a new line*/
+    #define AWKWARD_LINE_SIZE (2 * AWKWARD_WORD_SIZE + 2)
     
+    void encode_awkward_word(int, char*);
+    int decode_awkward_word(const char*);
+    char *encode_object_lines(char*, const word*, int, int);
     char *convert_to_awkward_base(word, char*);
     char *convert_int_to_awkward_base(int, char*);
     void print_word_ro_binary(word);